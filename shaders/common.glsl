@@ -0,0 +1,16 @@
+// blocks shared by every program, layouts mirror FrameConstants.h
+
+layout (std140, binding = 0) uniform FrameConstants {
+    vec3 lightPos;
+    float heightScale; // controls intensity of parallax effect
+    float time;
+    float deltaTime;
+    bool feedbackEnabled; // see TextureFeedback
+};
+
+layout (std140, binding = 1) uniform ViewConstants {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    vec3 viewPos;
+};
\ No newline at end of file
@@ -1,26 +1,141 @@
 #version 460 core
-in vec2 TexCoords;
-in vec3 FragPos;
-in mat3 TBN;
+#extension GL_GOOGLE_include_directive : require
+#ifdef MATERIAL_BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+layout (location = 0) in vec2 TexCoords;
+layout (location = 1) in vec3 FragPos;
+layout (location = 2) in mat3 TBN;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
 
-uniform sampler2D texture_diffuse1;
-uniform sampler2D texture_specular1;
-uniform sampler2D texture_normal1;
-uniform sampler2D texture_height1;
+// material features, set per variant (see ShaderVariants). glsl builds get them as defines,
+// spir-v builds as specialization constants, either way disabled branches are compiled out.
+// MATERIAL_* and VERTEX_PULLING change declarations, so they stay defines and variants using
+// them are always built from glsl (see ShaderProgram::buildSpirv)
+#ifdef GL_SPIRV
+layout (constant_id = 0) const bool HAS_DIFFUSE_MAP = false;
+layout (constant_id = 1) const bool HAS_SPECULAR_MAP = false;
+layout (constant_id = 2) const bool HAS_NORMAL_MAP = false;
+layout (constant_id = 3) const bool HAS_PARALLAX = false;
+#else
+#ifndef HAS_DIFFUSE_MAP
+#define HAS_DIFFUSE_MAP false
+#endif
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP false
+#endif
+#ifndef HAS_NORMAL_MAP
+#define HAS_NORMAL_MAP false
+#endif
+#ifndef HAS_PARALLAX
+#define HAS_PARALLAX false
+#endif
+#endif
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+#include "common.glsl"
 
-// controls intensity of parallax effect
-uniform float heightScale;
+// texture roles, matching TextureRole in Material.h
+const uint ROLE_DIFFUSE = 0u;
+const uint ROLE_SPECULAR = 1u;
+const uint ROLE_NORMAL = 2u;
+const uint ROLE_HEIGHT = 3u;
+
+#if defined(MATERIAL_BINDLESS) || defined(MATERIAL_ARRAYS)
+// textures of every material in one table indexed by id, so switching materials binds
+// nothing (see MaterialTable)
+#ifdef VERTEX_PULLING
+layout (location = 5) flat in int materialId; // from the draw's DrawData
+#else
+layout (location = 2) uniform int materialId;
+#endif
+struct MaterialRecord {
+    uvec2 handles[4]; // bindless handle per role
+    ivec2 slots[4]; // texture array and layer per role, x < 0 if unused
+};
+layout (std430, binding = 1) readonly buffer MaterialBuffer {
+    MaterialRecord materials[];
+};
+#endif
+
+#if defined(MATERIAL_BINDLESS)
+vec4 SampleMaterial(uint role, vec2 uv)
+{
+    return texture(sampler2D(materials[materialId].handles[role]), uv);
+}
+
+vec2 MaterialSize(uint role)
+{
+    return vec2(textureSize(sampler2D(materials[materialId].handles[role]), 0));
+}
+#elif defined(MATERIAL_ARRAYS)
+// arrays grouped by size and format, units from MaterialTable::FIRST_ARRAY_UNIT
+layout (binding = 4) uniform sampler2DArray materialArrays[8];
+
+vec4 SampleMaterial(uint role, vec2 uv)
+{
+    ivec2 slot = materials[materialId].slots[role];
+    if (slot.x < 0) return vec4(0.0);
+    return texture(materialArrays[slot.x], vec3(uv, slot.y));
+}
+
+vec2 MaterialSize(uint role)
+{
+    ivec2 slot = materials[materialId].slots[role];
+    if (slot.x < 0) return vec2(0.0);
+    return vec2(textureSize(materialArrays[slot.x], 0).xy);
+}
+#else
+// fixed units per texture role
+layout (binding = 0) uniform sampler2D texture_diffuse1;
+layout (binding = 1) uniform sampler2D texture_specular1;
+layout (binding = 2) uniform sampler2D texture_normal1;
+layout (binding = 3) uniform sampler2D texture_height1;
+
+vec4 SampleMaterial(uint role, vec2 uv)
+{
+    if (role == ROLE_DIFFUSE) return texture(texture_diffuse1, uv);
+    if (role == ROLE_SPECULAR) return texture(texture_specular1, uv);
+    if (role == ROLE_NORMAL) return texture(texture_normal1, uv);
+    return texture(texture_height1, uv);
+}
+
+vec2 MaterialSize(uint role)
+{
+    if (role == ROLE_DIFFUSE) return vec2(textureSize(texture_diffuse1, 0));
+    if (role == ROLE_SPECULAR) return vec2(textureSize(texture_specular1, 0));
+    if (role == ROLE_NORMAL) return vec2(textureSize(texture_normal1, 0));
+    return vec2(textureSize(texture_height1, 0));
+}
+#endif
+
+// texture usage feedback, desired mip per gl texture name (see TextureFeedback)
+// diffuse, specular, normal, height
+#ifdef VERTEX_PULLING
+layout (location = 6) flat in uvec4 feedbackTextureIds;
+#else
+layout (location = 1) uniform uvec4 feedbackTextureIds;
+#endif
+layout (std430, binding = 0) buffer TextureFeedbackBuffer {
+    uint desiredMip[];
+};
+
+// record the mip level a texture is sampled at. the lod comes from explicit uv gradients since
+// only some pixels of a quad write feedback, where implicit derivatives would be undefined
+void WriteFeedback(uint role, uint texId, vec2 uvDx, vec2 uvDy)
+{
+    if (texId == 0u || texId >= uint(desiredMip.length())) return;
+    vec2 size = MaterialSize(role);
+    vec2 dx = uvDx * size, dy = uvDy * size;
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    atomicMin(desiredMip[texId], uint(max(lod, 0.0)));
+}
 
 // parallax mapping
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir)
 {
     // get height from height map
-    float height = texture(texture_height1, texCoords).r;
+    float height = SampleMaterial(ROLE_HEIGHT, texCoords).r;
     // offset tex coords along view direction in tangent space
     vec2 p = viewDir.xy / viewDir.z * (height * heightScale);
     return texCoords - p;
@@ -31,18 +146,27 @@ void main()
     // compute view dir in tangent space
     vec3 viewDir = normalize(TBN * (viewPos - FragPos));
     
+    vec2 texCoords = TexCoords;
     // apply parallax mapping
-    vec2 texCoords = ParallaxMapping(TexCoords, viewDir);
-    
+    if (HAS_PARALLAX) texCoords = ParallaxMapping(TexCoords, viewDir);
+
+    // feedback gradients, taken in uniform control flow before anything can discard
+    vec2 uvDx = dFdx(texCoords), uvDy = dFdy(texCoords);
+    vec2 heightDx = dFdx(TexCoords), heightDy = dFdy(TexCoords);
+
     // discard frags if tex coords are out of bounds
-    if(texCoords.x > 1.0 || texCoords.x < 0.0 || texCoords.y > 1.0 || texCoords.y < 0.0) discard;
+    if (HAS_PARALLAX && (texCoords.x > 1.0 || texCoords.x < 0.0 || texCoords.y > 1.0 || texCoords.y < 0.0)) discard;
     
-    // sample normals and transform from [0,1] to [-1,1]
-    vec3 norm = texture(texture_normal1, texCoords).rgb;
-    norm = normalize(norm * 2.0 - 1.0);
+    vec3 norm = vec3(0.0, 0.0, 1.0);
+    if (HAS_NORMAL_MAP) {
+        // sample normals and transform from [0,1] to [-1,1]
+        norm = SampleMaterial(ROLE_NORMAL, texCoords).rgb;
+        norm = normalize(norm * 2.0 - 1.0);
+    }
     
     // sample diffuse
-    vec3 color = texture(texture_diffuse1, texCoords).rgb;
+    vec3 color = vec3(1.0);
+    if (HAS_DIFFUSE_MAP) color = SampleMaterial(ROLE_DIFFUSE, texCoords).rgb;
     
     // ambient lighting
     vec3 ambient = 0.1 * color;
@@ -53,9 +177,20 @@ void main()
     vec3 diffuse = diff * color;
     
     // specular lighting
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-    vec3 specular = texture(texture_specular1, texCoords).rgb * spec;
+    vec3 specular = vec3(0.0);
+    if (HAS_SPECULAR_MAP) {
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+        specular = SampleMaterial(ROLE_SPECULAR, texCoords).rgb * spec;
+    }
+    
+    // only every 4x4th pixel writes feedback, which is plenty to estimate residency
+    if (feedbackEnabled && ((int(gl_FragCoord.x) | int(gl_FragCoord.y)) & 3) == 0) {
+        if (HAS_DIFFUSE_MAP) WriteFeedback(ROLE_DIFFUSE, feedbackTextureIds.x, uvDx, uvDy);
+        if (HAS_SPECULAR_MAP) WriteFeedback(ROLE_SPECULAR, feedbackTextureIds.y, uvDx, uvDy);
+        if (HAS_NORMAL_MAP) WriteFeedback(ROLE_NORMAL, feedbackTextureIds.z, uvDx, uvDy);
+        if (HAS_PARALLAX) WriteFeedback(ROLE_HEIGHT, feedbackTextureIds.w, heightDx, heightDy);
+    }
     
     vec3 result = ambient + diffuse + specular;
     FragColor = vec4(result, 1.0);
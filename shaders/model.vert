@@ -1,31 +1,85 @@
 #version 460 core
+#extension GL_GOOGLE_include_directive : require
 
+#ifdef VERTEX_PULLING
+// vertices are fetched by gl_VertexID from GeometryPool's storage buffer and decoded here, so
+// every mesh shares one empty vertex array and any number of them fit in one multi-draw
+const int VERTEX_FLOATS = 22; // sizeof(Vertex) / 4, see Mesh.h
+layout (std430, binding = 2) readonly buffer VertexBuffer {
+    float vertexData[];
+};
+
+#include "scene.glsl"
+
+// per-draw values indexed by gl_DrawID
+layout (std430, binding = 3) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+layout (location = 3) uniform int drawBase; // first draw of the current multi-draw
+
+layout (location = 5) flat out int materialId;
+layout (location = 6) flat out uvec4 feedbackTextureIds;
+
+vec2 FetchVec2(int offset)
+{
+    return vec2(vertexData[offset], vertexData[offset + 1]);
+}
+
+vec3 FetchVec3(int offset)
+{
+    return vec3(vertexData[offset], vertexData[offset + 1], vertexData[offset + 2]);
+}
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
 
-out vec2 TexCoords;
-out vec3 FragPos;
-out mat3 TBN;
+// explicit locations so spir-v builds can be reflected (see Spirv.h)
+layout (location = 0) uniform mat4 model;
+#endif
+
+// copies drawn by Model::DrawInstanced read their transform by gl_InstanceID
+layout (std430, binding = 4) readonly buffer InstanceBuffer {
+    mat4 instances[];
+};
+layout (location = 4) uniform bool instanced;
+
+layout (location = 0) out vec2 TexCoords;
+layout (location = 1) out vec3 FragPos;
+layout (location = 2) out mat3 TBN;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common.glsl"
 
 void main()
 {
+#ifdef VERTEX_PULLING
+    // float offsets of the Vertex members
+    int base = gl_VertexID * VERTEX_FLOATS;
+    vec3 aPos = FetchVec3(base);
+    vec3 aNormal = FetchVec3(base + 3);
+    vec2 aTexCoords = FetchVec2(base + 6);
+    vec3 aTangent = FetchVec3(base + 8);
+    vec3 aBitangent = FetchVec3(base + 11);
+
+    DrawData draw = draws[drawBase + gl_DrawID];
+    mat4 model = objects[draw.objectId].world;
+    materialId = int(draw.materialId);
+    feedbackTextureIds = draw.feedbackTextureIds;
+#endif
+    mat4 world = instanced ? instances[gl_InstanceID] : model;
+
     // compute world-space pos of fragment
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(world * vec4(aPos, 1.0));
     TexCoords = aTexCoords;
     
     // transform tangent, bitangent, and normal to world space and form TBN matrix
-    vec3 T = normalize(vec3(model * vec4(aTangent, 0.0)));
-    vec3 B = normalize(vec3(model * vec4(aBitangent, 0.0)));
-    vec3 N = normalize(vec3(model * vec4(aNormal, 0.0)));
+    vec3 T = normalize(vec3(world * vec4(aTangent, 0.0)));
+    vec3 B = normalize(vec3(world * vec4(aBitangent, 0.0)));
+    vec3 N = normalize(vec3(world * vec4(aNormal, 0.0)));
     TBN = mat3(T, B, N);
     
     // transform vertex pos for clip space
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+// layouts shared by the vertex pulling path and gpu culling
+
+// world matrix, bounds and material of every object, mirrors ObjectData in SceneBuffer.h
+struct ObjectData {
+    mat4 world;
+    vec3 boundsMin;
+    uint materialId;
+    vec3 boundsMax;
+};
+layout (std430, binding = 5) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+// per-draw values, mirrors DrawData in RenderQueue.h
+struct DrawData {
+    uvec4 feedbackTextureIds;
+    uint objectId;
+    uint materialId;
+    uint batch; // program batch, for culling
+    uint batchFirst; // first draw of the batch
+};
+
+// mirrors DrawCommand in GeometryPool.h
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
\ No newline at end of file
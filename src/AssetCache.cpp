@@ -0,0 +1,120 @@
+#include "AssetCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+static constexpr const char* ENTRY_EXTENSION = ".bin";
+static constexpr const char* TEMP_EXTENSION = ".tmp";
+
+AssetCache::AssetCache(const std::string& dir, uintmax_t sizeCap) : dir(dir), sizeCap(sizeCap) {
+    std::error_code ec;
+    std::filesystem::create_directories(this->dir, ec);
+    if (ec) fprintf(stderr, "Failed to create asset cache directory: %s\n", dir.c_str());
+    collectGarbage();
+}
+
+bool AssetCache::hashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    hash = FNV_OFFSET_BASIS;
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+        hash = fnv1a(buffer, (size_t)file.gcount(), hash);
+    return true;
+}
+
+uint64_t AssetCache::makeKey(uint64_t sourceHash, uint64_t settings, std::string_view kind) {
+    uint64_t key = fnv1a(&sourceHash, sizeof(sourceHash));
+    key = fnv1a(&settings, sizeof(settings), key);
+    key = fnv1a(&CONVERTER_VERSION, sizeof(CONVERTER_VERSION), key);
+    return fnv1a(kind, key);
+}
+
+bool AssetCache::load(uint64_t key, std::vector<char>& out) const {
+    std::filesystem::path path = entryPath(key);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    std::streamsize size = file.tellg();
+    out.resize((size_t)size);
+    file.seekg(0);
+    if (!file.read(out.data(), size)) return false;
+
+    // refresh the entry's age for garbage collection, failing to do so is harmless
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool AssetCache::store(uint64_t key, const void* data, size_t size) const {
+    std::filesystem::path path = entryPath(key);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) return true;
+
+    // write privately, then publish atomically so readers never see a partial entry
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%zx.%u%s",
+        std::hash<std::thread::id>{}(std::this_thread::get_id()), tempCounter++, TEMP_EXTENSION);
+    std::filesystem::path temp = path;
+    temp += suffix;
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file || !file.write((const char*)data, (std::streamsize)size)) {
+            fprintf(stderr, "Failed to write asset cache entry: %s\n", temp.string().c_str());
+            file.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return std::filesystem::exists(path, ec); // another thread may have won the race
+    }
+    return true;
+}
+
+void AssetCache::remove(uint64_t key) const {
+    std::error_code ec;
+    std::filesystem::remove(entryPath(key), ec);
+}
+
+void AssetCache::collectGarbage() const {
+    struct Entry {
+        std::filesystem::path path;
+        uintmax_t size;
+        std::filesystem::file_time_type time;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        if (!file.is_regular_file(ec)) continue;
+        // leftovers from interrupted writes
+        if (file.path().extension() == TEMP_EXTENSION) {
+            std::filesystem::remove(file.path(), ec);
+            continue;
+        }
+        Entry entry = { file.path(), file.file_size(ec), file.last_write_time(ec) };
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= sizeCap) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& entry : entries) {
+        if (total <= sizeCap) break;
+        if (std::filesystem::remove(entry.path, ec)) total -= entry.size;
+    }
+}
+
+std::filesystem::path AssetCache::entryPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx%s", (unsigned long long)key, ENTRY_EXTENSION);
+    return dir / name;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Hash.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// content-addressed store for derived asset data (converted meshes, optimised indices, compressed
+// textures, lods, ...). entries are immutable files named after a key covering everything that
+// produced them, so a stale entry is never looked up, it just ages out of the size cap.
+//
+// lookups touch no shared state and writes go through a unique temp file and an atomic rename,
+// so any number of threads can use one cache without locking.
+class AssetCache {
+public:
+    // bump whenever a converter or a cached format changes, invalidating every entry
+    static constexpr uint32_t CONVERTER_VERSION = 2;
+    static constexpr uintmax_t DEFAULT_SIZE_CAP = 512ull << 20;
+
+    AssetCache(const std::string& dir = "cache", uintmax_t sizeCap = DEFAULT_SIZE_CAP);
+
+    // hash of a source file's contents, false if it cannot be read
+    static bool hashFile(const std::string& path, uint64_t& hash);
+    // combine a source hash with the settings used to process it and the kind of derived data
+    static uint64_t makeKey(uint64_t sourceHash, uint64_t settings, std::string_view kind);
+
+    bool load(uint64_t key, std::vector<char>& out) const;
+    bool store(uint64_t key, const void* data, size_t size) const;
+    // drop an entry that turned out unusable, e.g. a program binary the driver rejects, so the
+    // next store can replace it
+    void remove(uint64_t key) const;
+
+    // delete least recently used entries until the directory fits the size cap
+    void collectGarbage() const;
+
+private:
+    std::filesystem::path dir;
+    uintmax_t sizeCap;
+    mutable std::atomic<uint32_t> tempCounter = 0;
+
+    std::filesystem::path entryPath(uint64_t key) const;
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "FileWatcher.h"
+
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static std::string normalizePath(const std::filesystem::path& path) {
+    return path.lexically_normal().generic_string();
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() {
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) fprintf(stderr, "Failed to init inotify\n");
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd >= 0) close(fd);
+}
+
+void FileWatcher::watch(const std::string& dir) {
+    // inotify is not recursive, so every directory gets its own watch
+    std::error_code ec;
+    addWatch(dir);
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        if (it->is_directory(ec)) addWatch(it->path().string());
+}
+
+void FileWatcher::addWatch(const std::string& dir) {
+    if (fd < 0) return;
+    int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        fprintf(stderr, "Failed to watch directory: %s\n", dir.c_str());
+        return;
+    }
+    watchDirs[wd] = normalizePath(dir);
+}
+
+void FileWatcher::poll() {
+    if (fd < 0) return;
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t len;
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len) {
+            const inotify_event* event = (const inotify_event*)ptr;
+            auto dir = watchDirs.find(event->wd);
+            if (dir == watchDirs.end() || event->len == 0) continue;
+
+            std::string path = normalizePath(std::filesystem::path(dir->second) / event->name);
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & IN_CREATE) watch(path);
+            }
+            // files are reported once fully written, IN_CREATE alone is still empty
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                changed.insert(path);
+            }
+        }
+    }
+
+    // editors often write a file several times in a row, each path is reported once per poll
+    for (const std::string& path : changed)
+        for (const auto& callback : callbacks)
+            callback(path);
+    changed.clear();
+}
+
+#else
+
+FileWatcher::FileWatcher() : lastScan(std::chrono::steady_clock::now()) {}
+
+FileWatcher::~FileWatcher() {}
+
+void FileWatcher::watch(const std::string& dir) {
+    roots.push_back(dir);
+    scan(false);
+}
+
+void FileWatcher::poll() {
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastScan).count() < POLL_INTERVAL) return;
+    lastScan = now;
+
+    scan(true);
+    for (const std::string& path : changed)
+        for (const auto& callback : callbacks)
+            callback(path);
+    changed.clear();
+}
+
+void FileWatcher::scan(bool report) {
+    std::error_code ec;
+    for (const std::string& root : roots) {
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            auto time = it->last_write_time(ec);
+            std::string path = normalizePath(it->path());
+            auto entry = writeTimes.find(path);
+            if (entry == writeTimes.end()) {
+                writeTimes.emplace(path, time);
+                if (report) changed.insert(path);
+            }
+            else if (entry->second != time) {
+                entry->second = time;
+                if (report) changed.insert(path);
+            }
+        }
+    }
+}
+
+#endif
+
+void FileWatcher::addCallback(std::function<void(const std::string& path)> callback) {
+    callbacks.push_back(callback);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// reports files that changed under the watched directories, uses inotify where available
+// and falls back to polling modification times elsewhere
+class FileWatcher {
+public:
+    static constexpr double POLL_INTERVAL = 0.5; // seconds between scans for the polling fallback
+
+    FileWatcher();
+    ~FileWatcher();
+
+    // watch a directory and everything below it
+    void watch(const std::string& dir);
+    // called once per changed file per poll with a normalised relative path, e.g. "shaders/model.frag"
+    void addCallback(std::function<void(const std::string& path)> callback);
+    // collect pending changes and dispatch callbacks, call once per frame
+    void poll();
+
+private:
+    std::vector<std::function<void(const std::string& path)>> callbacks;
+    std::unordered_set<std::string> changed;
+
+#ifdef __linux__
+    int fd = -1;
+    std::unordered_map<int, std::string> watchDirs; // watch descriptor -> directory
+    void addWatch(const std::string& dir);
+#else
+    std::vector<std::string> roots;
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+    std::chrono::steady_clock::time_point lastScan;
+    void scan(bool report);
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "FrameConstants.h"
+#include "GLState.h"
+
+#include <cstdio>
+
+static bool checkBlock(const ShaderProgram& program, const char* name, uint32_t binding, size_t size) {
+    const ShaderProgram::Block* block = program.findBlock(name);
+    if (!block) return true; // not used by this program
+    if (block->storage || block->binding != (int32_t)binding || block->dataSize != (int32_t)size) {
+        fprintf(stderr, "Uniform block %s does not match its C++ struct (binding %d, %d bytes, expected binding %u, %zu bytes)\n",
+            name, block->binding, block->dataSize, binding, size);
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+static void bindConstants(RingBuffer& ring, const T& value) {
+    RingBuffer::Allocation allocation = ring.writeUniform(value);
+    if (allocation.data)
+        GLState::bindBufferRange(GL_UNIFORM_BUFFER, T::BINDING, allocation.buffer, allocation.offset, allocation.size);
+}
+
+void ConstantBuffers::update(const FrameConstants& frame) {
+    bindConstants(ring, frame);
+}
+
+void ConstantBuffers::update(const ViewConstants& view) {
+    bindConstants(ring, view);
+}
+
+bool ConstantBuffers::validate(const ShaderProgram& program) {
+    bool valid = checkBlock(program, "FrameConstants", FrameConstants::BINDING, sizeof(FrameConstants));
+    valid &= checkBlock(program, "ViewConstants", ViewConstants::BINDING, sizeof(ViewConstants));
+    return valid;
+}
\ No newline at end of file
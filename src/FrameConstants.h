@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "RingBuffer.h"
+#include <cstddef>
+
+// std140 mirrors of the uniform blocks every program shares, the glsl side lives in
+// shaders/common.glsl and must be kept in sync with these
+
+// scene-wide values, uploaded once a frame
+struct FrameConstants {
+    static constexpr uint32_t BINDING = 0;
+
+    glm::vec3 lightPos;
+    float heightScale; // parallax intensity
+    float time; // seconds since startup
+    float deltaTime;
+    uint32_t feedbackEnabled; // glsl bool, see TextureFeedback
+    float pad;
+};
+static_assert(offsetof(FrameConstants, lightPos) == 0);
+static_assert(offsetof(FrameConstants, heightScale) == 12);
+static_assert(offsetof(FrameConstants, time) == 16);
+static_assert(offsetof(FrameConstants, deltaTime) == 20);
+static_assert(offsetof(FrameConstants, feedbackEnabled) == 24);
+static_assert(sizeof(FrameConstants) == 32);
+
+// camera values, uploaded once per view
+struct ViewConstants {
+    static constexpr uint32_t BINDING = 1;
+
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 viewProjection;
+    glm::vec3 viewPos;
+    float pad;
+};
+static_assert(offsetof(ViewConstants, projection) == 0);
+static_assert(offsetof(ViewConstants, view) == 64);
+static_assert(offsetof(ViewConstants, viewProjection) == 128);
+static_assert(offsetof(ViewConstants, viewPos) == 192);
+static_assert(sizeof(ViewConstants) == 208);
+
+// writes both blocks into the frame's ring buffer region and binds the ranges at their fixed
+// binding points, so programs read them without any per-program uniform uploads
+class ConstantBuffers {
+public:
+    ConstantBuffers(RingBuffer& ring) : ring(ring) {}
+
+    // call between RingBuffer::beginFrame and endFrame
+    void update(const FrameConstants& frame);
+    void update(const ViewConstants& view);
+
+    // reports blocks whose binding or size in the program disagree with the structs above
+    static bool validate(const ShaderProgram& program);
+
+private:
+    RingBuffer& ring;
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "FrameSync.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+FrameSync::FrameSync(uint32_t framesInFlight) : framesInFlight(std::clamp<uint32_t>(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT)) {
+    glCreateQueries(GL_TIME_ELAPSED, MAX_FRAMES_IN_FLIGHT, queries);
+}
+
+FrameSync::~FrameSync() {
+    for (GLsync fence : fences)
+        if (fence) glDeleteSync(fence);
+    glDeleteQueries(MAX_FRAMES_IN_FLIGHT, queries);
+}
+
+void FrameSync::setFramesInFlight(uint32_t count) {
+    count = std::clamp<uint32_t>(count, 1, MAX_FRAMES_IN_FLIGHT);
+    if (count == framesInFlight) return;
+
+    // slots map to different frames afterwards, so nothing may still be in flight. the drained
+    // frames' timings are dropped, a slot unused until the count grows again would report stale ones
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        waitFence(i);
+        queryPending[i] = false;
+    }
+    framesInFlight = count;
+}
+
+void FrameSync::beginFrame() {
+    slot = (uint32_t)(frame % framesInFlight);
+    waitFence(slot);
+
+    // the fence was placed after the query ended, so its result is available without stalling
+    if (queryPending[slot]) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+        Profiler::addTime(Profiler::Stat::GpuFrameTime, ns / 1000000.0);
+        queryPending[slot] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+}
+
+void FrameSync::endFrame() {
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[slot] = true;
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame++;
+}
+
+void FrameSync::waitFence(uint32_t slot) {
+    GLsync& fence = fences[slot];
+    if (!fence) return;
+
+    // poll first so the common case never starts a timer
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        Profiler::ScopedTimer timer(Profiler::Stat::FrameWaitTime);
+        do status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED) fprintf(stderr, "Waiting on frame fence failed\n");
+    glDeleteSync(fence);
+    fence = nullptr;
+}
\ No newline at end of file
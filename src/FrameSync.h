@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+// limits how many frames the cpu may queue ahead of the gpu. each frame gets a slot with a fence
+// and a timer query, and beginFrame blocks until the frame that last used the slot has finished.
+// per-frame resources such as ring buffer regions are indexed by getSlot()
+// NOTE: not thread safe, only call from the thread that owns the gl context
+class FrameSync {
+public:
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+    FrameSync(uint32_t framesInFlight = 2);
+    ~FrameSync();
+
+    // clamped to [1, MAX_FRAMES_IN_FLIGHT], drains the gpu when the count changes
+    void setFramesInFlight(uint32_t count);
+    uint32_t getFramesInFlight() const { return framesInFlight; }
+
+    // waits for this frame's slot, time spent blocked is profiled, and starts the gpu timer
+    void beginFrame();
+    // stops the gpu timer and fences the frame, call after the last gl command of the frame
+    void endFrame();
+
+    uint32_t getSlot() const { return slot; }
+
+private:
+    GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t queries[MAX_FRAMES_IN_FLIGHT] = {};
+    bool queryPending[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t framesInFlight;
+    uint64_t frame = 0;
+    uint32_t slot = 0;
+
+    void waitFence(uint32_t slot);
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "GLExtensions.h"
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+
+void GLExtensions::init() {
+    if (has("GL_KHR_parallel_shader_compile") || has("GL_ARB_parallel_shader_compile")) {
+        glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        if (!glMaxShaderCompilerThreadsKHR)
+            glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+        parallelShaderCompile = glMaxShaderCompilerThreadsKHR != nullptr;
+        // let the driver pick how many compiler threads to use
+        if (parallelShaderCompile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+
+    if (has("GL_ARB_bindless_texture")) {
+        glGetTextureHandleARB = (PFNGLGETTEXTUREHANDLEARBPROC)glfwGetProcAddress("glGetTextureHandleARB");
+        glMakeTextureHandleResidentARB = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+        glMakeTextureHandleNonResidentARB = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+        bindlessTexture = glGetTextureHandleARB && glMakeTextureHandleResidentARB && glMakeTextureHandleNonResidentARB;
+    }
+}
+
+bool GLExtensions::has(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
\ No newline at end of file
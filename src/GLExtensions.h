@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// the glad loader only covers core 4.6, extensions the renderer can use are detected and
+// loaded here instead. call init() once after glad, then check the flags before use
+
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// ARB_bindless_texture
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+class GLExtensions {
+public:
+    static inline bool parallelShaderCompile = false;
+    static inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR = nullptr;
+
+    static inline bool bindlessTexture = false;
+    static inline PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB = nullptr;
+    static inline PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB = nullptr;
+    static inline PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB = nullptr;
+
+    static void init();
+    static bool has(const char* name);
+};
\ No newline at end of file
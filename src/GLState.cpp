@@ -0,0 +1,140 @@
+#include "GLState.h"
+#include "Profiler.h"
+
+static constexpr uint32_t UNKNOWN = 0xFFFFFFFF;
+
+// generic buffer targets that are cached, anything else is always issued
+static constexpr GLenum BUFFER_TARGETS[] = {
+    GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+    GL_PARAMETER_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+};
+static constexpr size_t BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+
+static constexpr GLenum CAPABILITIES[] = {
+    GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_FRAMEBUFFER_SRGB,
+};
+static constexpr size_t CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+static uint32_t program;
+static uint32_t vertexArray;
+static uint32_t buffers[BUFFER_TARGET_COUNT];
+static uint32_t uniformBindings[GLState::MAX_BUFFER_BINDINGS];
+static uint32_t storageBindings[GLState::MAX_BUFFER_BINDINGS];
+static uint32_t textures[GLState::MAX_TEXTURE_UNITS];
+static uint32_t samplers[GLState::MAX_TEXTURE_UNITS];
+static uint32_t capabilities[CAPABILITY_COUNT];
+static uint32_t polygonModeState;
+static uint32_t unpackAlignment;
+
+template <size_t N>
+static int indexOf(const GLenum (&values)[N], GLenum value) {
+    for (size_t i = 0; i < N; i++)
+        if (values[i] == value) return (int)i;
+    return -1;
+}
+
+// true if the call has to be issued, and records the new value
+static bool update(uint32_t& cached, uint32_t value) {
+    if (cached == value) {
+        Profiler::count(Profiler::Stat::StateCallsElided);
+        return false;
+    }
+    cached = value;
+    Profiler::count(Profiler::Stat::StateCallsIssued);
+    return true;
+}
+
+static uint32_t* indexedBindings(GLenum target) {
+    if (target == GL_UNIFORM_BUFFER) return uniformBindings;
+    if (target == GL_SHADER_STORAGE_BUFFER) return storageBindings;
+    return nullptr;
+}
+
+void GLState::useProgram(uint32_t id) {
+    if (update(program, id)) glUseProgram(id);
+}
+
+void GLState::bindVertexArray(uint32_t id) {
+    if (update(vertexArray, id)) glBindVertexArray(id);
+}
+
+void GLState::bindBuffer(GLenum target, uint32_t buffer) {
+    int index = indexOf(BUFFER_TARGETS, target);
+    if (index < 0) {
+        Profiler::count(Profiler::Stat::StateCallsIssued);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (update(buffers[index], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferBase(GLenum target, uint32_t index, uint32_t buffer) {
+    uint32_t* bindings = indexedBindings(target);
+    if (!bindings || index >= MAX_BUFFER_BINDINGS) {
+        Profiler::count(Profiler::Stat::StateCallsIssued);
+        glBindBufferBase(target, index, buffer);
+    }
+    else if (update(bindings[index], buffer)) glBindBufferBase(target, index, buffer);
+    else return;
+
+    // also replaces the generic binding
+    int generic = indexOf(BUFFER_TARGETS, target);
+    if (generic >= 0) buffers[generic] = buffer;
+}
+
+void GLState::bindBufferRange(GLenum target, uint32_t index, uint32_t buffer, size_t offset, size_t size) {
+    Profiler::count(Profiler::Stat::StateCallsIssued);
+    glBindBufferRange(target, index, buffer, (GLintptr)offset, (GLsizeiptr)size);
+
+    // the indexed binding no longer covers the whole buffer, the generic one is replaced
+    uint32_t* bindings = indexedBindings(target);
+    if (bindings && index < MAX_BUFFER_BINDINGS) bindings[index] = UNKNOWN;
+    int generic = indexOf(BUFFER_TARGETS, target);
+    if (generic >= 0) buffers[generic] = buffer;
+}
+
+void GLState::bindTextureUnit(uint32_t unit, uint32_t texture) {
+    if (unit >= MAX_TEXTURE_UNITS) {
+        Profiler::count(Profiler::Stat::StateCallsIssued);
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+    if (update(textures[unit], texture)) glBindTextureUnit(unit, texture);
+}
+
+void GLState::bindSampler(uint32_t unit, uint32_t sampler) {
+    if (unit >= MAX_TEXTURE_UNITS) {
+        Profiler::count(Profiler::Stat::StateCallsIssued);
+        glBindSampler(unit, sampler);
+        return;
+    }
+    if (update(samplers[unit], sampler)) glBindSampler(unit, sampler);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    int index = indexOf(CAPABILITIES, capability);
+    if (index >= 0 && !update(capabilities[index], enabled)) return;
+    if (index < 0) Profiler::count(Profiler::Stat::StateCallsIssued);
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void GLState::polygonMode(GLenum mode) {
+    if (update(polygonModeState, mode)) glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::pixelStore(GLenum name, int value) {
+    if (name == GL_UNPACK_ALIGNMENT && !update(unpackAlignment, (uint32_t)value)) return;
+    if (name != GL_UNPACK_ALIGNMENT) Profiler::count(Profiler::Stat::StateCallsIssued);
+    glPixelStorei(name, value);
+}
+
+void GLState::invalidate() {
+    program = vertexArray = polygonModeState = unpackAlignment = UNKNOWN;
+    for (uint32_t& buffer : buffers) buffer = UNKNOWN;
+    for (uint32_t& binding : uniformBindings) binding = UNKNOWN;
+    for (uint32_t& binding : storageBindings) binding = UNKNOWN;
+    for (uint32_t& texture : textures) texture = UNKNOWN;
+    for (uint32_t& sampler : samplers) sampler = UNKNOWN;
+    for (uint32_t& capability : capabilities) capability = UNKNOWN;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// shadows the gl binding and raster state the renderer touches and skips calls that would not
+// change it. textures are bound with glBindTextureUnit and resources are edited through dsa,
+// so the active texture unit is never touched. call invalidate() after code that changes state
+// behind its back (imgui, third party renderers) or that deletes objects, gl unbinds deleted
+// names and a recycled name would otherwise look bound already
+// NOTE: not thread safe, only call from the thread that owns the gl context
+class GLState {
+public:
+    static constexpr uint32_t MAX_TEXTURE_UNITS = 32;
+    static constexpr uint32_t MAX_BUFFER_BINDINGS = 16; // indexed uniform and storage bindings
+
+    static void useProgram(uint32_t program);
+    static void bindVertexArray(uint32_t vertexArray);
+    // element array bindings belong to the vertex array and are never elided
+    static void bindBuffer(GLenum target, uint32_t buffer);
+    static void bindBufferBase(GLenum target, uint32_t index, uint32_t buffer);
+    // ranges move every frame, these are always issued
+    static void bindBufferRange(GLenum target, uint32_t index, uint32_t buffer, size_t offset, size_t size);
+    // bind a texture of any target to a unit
+    static void bindTextureUnit(uint32_t unit, uint32_t texture);
+    static void bindSampler(uint32_t unit, uint32_t sampler);
+
+    static void setEnabled(GLenum capability, bool enabled);
+    static void polygonMode(GLenum mode);
+    static void pixelStore(GLenum name, int value);
+
+    // forget everything, the next call of each kind is always issued
+    // also call once after the context is created, the cache starts out zeroed
+    static void invalidate();
+};
\ No newline at end of file
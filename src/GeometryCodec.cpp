@@ -0,0 +1,337 @@
+#include "GeometryCodec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+static constexpr uint32_t VERTEX_MAGIC = 0x31585456; // "VTX1"
+static constexpr uint32_t INDEX_MAGIC = 0x31584449; // "IDX1"
+static constexpr uint32_t FLAG_ZERO_RUNS = 1;
+
+// magic, element count, stride, flags, block count
+static constexpr size_t HEADER_SIZE = 5 * sizeof(uint32_t);
+
+struct StreamHeader {
+    uint32_t magic, count, stride, flags, blockCount;
+};
+
+struct BlockEntry {
+    uint32_t offset, size; // relative to the start of the block data
+};
+
+// varints and zero runs
+
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static bool readVarint(const uint8_t*& ptr, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (ptr == end) return false;
+        uint8_t byte = *ptr++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+// zero bytes become a 0 marker followed by the run length - 1, everything else is literal
+static void encodeZeroRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < size) {
+        if (data[i] != 0) {
+            out.push_back(data[i++]);
+            continue;
+        }
+        size_t run = 1;
+        while (i + run < size && data[i + run] == 0 && run < 0xFFFFFFFFu) run++;
+        out.push_back(0);
+        writeVarint(out, (uint32_t)(run - 1));
+        i += run;
+    }
+}
+
+// expands into dst, which has room for capacity bytes, and reports how many were written
+static bool decodeZeroRuns(const uint8_t* ptr, const uint8_t* end, uint8_t* dst, size_t capacity, size_t& written) {
+    uint8_t* out = dst;
+    uint8_t* outEnd = dst + capacity;
+    while (ptr < end) {
+        if (out == outEnd) return false;
+        uint8_t byte = *ptr++;
+        if (byte != 0) {
+            *out++ = byte;
+            continue;
+        }
+        uint32_t run;
+        if (!readVarint(ptr, end, run) || (size_t)(outEnd - out) < (size_t)run + 1) return false;
+        std::memset(out, 0, (size_t)run + 1);
+        out += (size_t)run + 1;
+    }
+    written = out - dst;
+    return true;
+}
+
+// stream framing
+
+static void writeHeader(std::vector<uint8_t>& out, const StreamHeader& header, size_t& tableOffset) {
+    out.resize(HEADER_SIZE + header.blockCount * sizeof(BlockEntry));
+    std::memcpy(out.data(), &header, HEADER_SIZE);
+    tableOffset = HEADER_SIZE;
+}
+
+static bool readHeader(const uint8_t* data, size_t size, uint32_t magic, StreamHeader& header,
+    const BlockEntry*& table, const uint8_t*& blocks, size_t& blocksSize) {
+    if (size < HEADER_SIZE) return false;
+    std::memcpy(&header, data, HEADER_SIZE);
+    if (header.magic != magic || header.stride == 0) return false;
+
+    size_t tableSize = (size_t)header.blockCount * sizeof(BlockEntry);
+    if (size - HEADER_SIZE < tableSize) return false;
+    table = (const BlockEntry*)(data + HEADER_SIZE);
+    blocks = data + HEADER_SIZE + tableSize;
+    blocksSize = size - HEADER_SIZE - tableSize;
+    for (uint32_t i = 0; i < header.blockCount; i++) {
+        BlockEntry entry;
+        std::memcpy(&entry, &table[i], sizeof(entry));
+        if ((size_t)entry.offset + entry.size > blocksSize) return false;
+    }
+    return true;
+}
+
+// runs decodeBlock for every block, on the pool if there is one
+static bool forEachBlock(uint32_t blockCount, ThreadPool* pool, const std::function<bool(uint32_t)>& decodeBlock) {
+    std::atomic<bool> ok = true;
+    auto run = [&](size_t block) {
+        if (!decodeBlock((uint32_t)block)) ok = false;
+    };
+    if (pool) pool->parallelFor(blockCount, run);
+    else for (uint32_t i = 0; i < blockCount; i++) run(i);
+    return ok;
+}
+
+// vertices
+
+// transposes an 8x8 byte matrix held as 8 little-endian rows
+static inline void transposeBytes8x8(uint64_t rows[8]) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t t = ((rows[i] >> 32) ^ rows[i + 4]) & 0x00000000FFFFFFFFull;
+        rows[i] ^= t << 32;
+        rows[i + 4] ^= t;
+    }
+    for (int i : { 0, 1, 4, 5 }) {
+        uint64_t t = ((rows[i] >> 16) ^ rows[i + 2]) & 0x0000FFFF0000FFFFull;
+        rows[i] ^= t << 16;
+        rows[i + 2] ^= t;
+    }
+    for (int i = 0; i < 8; i += 2) {
+        uint64_t t = ((rows[i] >> 8) ^ rows[i + 1]) & 0x00FF00FF00FF00FFull;
+        rows[i] ^= t << 8;
+        rows[i + 1] ^= t;
+    }
+}
+
+// adds the 8 bytes of a and b lane by lane without carries between lanes
+static inline uint64_t addBytes(uint64_t a, uint64_t b) {
+    constexpr uint64_t HIGH = 0x8080808080808080ull;
+    return ((a & ~HIGH) + (b & ~HIGH)) ^ ((a ^ b) & HIGH);
+}
+
+void encodeVertices(const void* vertices, size_t count, size_t stride, bool zeroRuns, std::vector<uint8_t>& out) {
+    const uint8_t* src = (const uint8_t*)vertices;
+    StreamHeader header = { VERTEX_MAGIC, (uint32_t)count, (uint32_t)stride,
+        zeroRuns ? FLAG_ZERO_RUNS : 0, (uint32_t)((count + VERTEX_BLOCK_SIZE - 1) / VERTEX_BLOCK_SIZE) };
+    size_t tableOffset;
+    writeHeader(out, header, tableOffset);
+    size_t blocksStart = out.size();
+
+    std::vector<uint8_t> planes;
+    for (uint32_t block = 0; block < header.blockCount; block++) {
+        size_t first = (size_t)block * VERTEX_BLOCK_SIZE;
+        size_t n = std::min<size_t>(VERTEX_BLOCK_SIZE, count - first);
+        const uint8_t* blockSrc = src + first * stride;
+
+        // byte planes, each delta coded along the block
+        planes.resize(n * stride);
+        for (size_t b = 0; b < stride; b++) {
+            uint8_t prev = 0;
+            uint8_t* plane = planes.data() + b * n;
+            for (size_t i = 0; i < n; i++) {
+                uint8_t value = blockSrc[i * stride + b];
+                plane[i] = (uint8_t)(value - prev);
+                prev = value;
+            }
+        }
+
+        BlockEntry entry = { (uint32_t)(out.size() - blocksStart), 0 };
+        if (zeroRuns) encodeZeroRuns(planes.data(), planes.size(), out);
+        else out.insert(out.end(), planes.begin(), planes.end());
+        entry.size = (uint32_t)(out.size() - blocksStart - entry.offset);
+        std::memcpy(out.data() + tableOffset + block * sizeof(BlockEntry), &entry, sizeof(entry));
+    }
+}
+
+bool encodedVertexInfo(const uint8_t* data, size_t size, size_t& count, size_t& stride) {
+    StreamHeader header;
+    const BlockEntry* table;
+    const uint8_t* blocks;
+    size_t blocksSize;
+    if (!readHeader(data, size, VERTEX_MAGIC, header, table, blocks, blocksSize)) return false;
+    // the block table was bounds checked, so a matching count is too, callers allocate from it
+    if (header.blockCount != ((size_t)header.count + VERTEX_BLOCK_SIZE - 1) / VERTEX_BLOCK_SIZE) return false;
+    count = header.count;
+    stride = header.stride;
+    return true;
+}
+
+bool decodeVertices(const uint8_t* data, size_t size, void* dst, ThreadPool* pool) {
+    StreamHeader header;
+    const BlockEntry* table;
+    const uint8_t* blocks;
+    size_t blocksSize;
+    if (!readHeader(data, size, VERTEX_MAGIC, header, table, blocks, blocksSize)) return false;
+    if (header.blockCount != ((size_t)header.count + VERTEX_BLOCK_SIZE - 1) / VERTEX_BLOCK_SIZE) return false;
+
+    const size_t stride = header.stride;
+    return forEachBlock(header.blockCount, pool, [&](uint32_t block) {
+        BlockEntry entry;
+        std::memcpy(&entry, &table[block], sizeof(entry));
+        size_t first = (size_t)block * VERTEX_BLOCK_SIZE;
+        size_t n = std::min<size_t>(VERTEX_BLOCK_SIZE, header.count - first);
+        const uint8_t* src = blocks + entry.offset;
+
+        // planes are expanded into per-thread scratch when zero runs are in use
+        thread_local std::vector<uint8_t> scratch;
+        const uint8_t* planes = src;
+        if (header.flags & FLAG_ZERO_RUNS) {
+            scratch.resize(n * stride);
+            size_t written;
+            if (!decodeZeroRuns(src, src + entry.size, scratch.data(), scratch.size(), written) || written != scratch.size())
+                return false;
+            planes = scratch.data();
+        }
+        else if (entry.size != n * stride) {
+            return false;
+        }
+
+        // 8x8 byte tiles (8 vertices by 8 planes) are transposed back to vertex order in
+        // registers, then the deltas are undone 8 bytes at a time with lane-wise adds
+        uint8_t* out = (uint8_t*)dst + first * stride;
+        const size_t wideStride = stride & ~(size_t)7;
+        const size_t wideCount = n & ~(size_t)7;
+        thread_local std::vector<uint64_t> state;
+        state.assign(wideStride / 8, 0);
+        for (size_t i = 0; i < wideCount; i += 8) {
+            for (size_t b = 0; b < wideStride; b += 8) {
+                uint64_t rows[8];
+                for (size_t k = 0; k < 8; k++)
+                    std::memcpy(&rows[k], planes + (b + k) * n + i, 8);
+                transposeBytes8x8(rows);
+                uint64_t value = state[b / 8];
+                for (size_t k = 0; k < 8; k++) {
+                    value = addBytes(value, rows[k]);
+                    std::memcpy(out + (i + k) * stride + b, &value, 8);
+                }
+                state[b / 8] = value;
+            }
+        }
+
+        // leftover planes and vertices
+        for (size_t b = 0; b < stride; b++) {
+            const uint8_t* plane = planes + b * n;
+            size_t i = b < wideStride ? wideCount : 0;
+            uint8_t value = i > 0 ? out[(i - 1) * stride + b] : 0;
+            for (; i < n; i++) {
+                value += plane[i];
+                out[i * stride + b] = value;
+            }
+        }
+        return true;
+    });
+}
+
+// indices
+
+void encodeIndices(const uint32_t* indices, size_t count, bool zeroRuns, std::vector<uint8_t>& out) {
+    StreamHeader header = { INDEX_MAGIC, (uint32_t)count, sizeof(uint32_t),
+        zeroRuns ? FLAG_ZERO_RUNS : 0, (uint32_t)((count + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE) };
+    size_t tableOffset;
+    writeHeader(out, header, tableOffset);
+    size_t blocksStart = out.size();
+
+    std::vector<uint8_t> varints;
+    for (uint32_t block = 0; block < header.blockCount; block++) {
+        size_t first = (size_t)block * INDEX_BLOCK_SIZE;
+        size_t n = std::min<size_t>(INDEX_BLOCK_SIZE, count - first);
+
+        varints.clear();
+        uint32_t prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t index = indices[first + i];
+            writeVarint(varints, zigzag((int32_t)(index - prev)));
+            prev = index;
+        }
+
+        BlockEntry entry = { (uint32_t)(out.size() - blocksStart), 0 };
+        if (zeroRuns) encodeZeroRuns(varints.data(), varints.size(), out);
+        else out.insert(out.end(), varints.begin(), varints.end());
+        entry.size = (uint32_t)(out.size() - blocksStart - entry.offset);
+        std::memcpy(out.data() + tableOffset + block * sizeof(BlockEntry), &entry, sizeof(entry));
+    }
+}
+
+bool encodedIndexCount(const uint8_t* data, size_t size, size_t& count) {
+    StreamHeader header;
+    const BlockEntry* table;
+    const uint8_t* blocks;
+    size_t blocksSize;
+    if (!readHeader(data, size, INDEX_MAGIC, header, table, blocks, blocksSize)) return false;
+    if (header.blockCount != ((size_t)header.count + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE) return false;
+    count = header.count;
+    return true;
+}
+
+bool decodeIndices(const uint8_t* data, size_t size, uint32_t* dst, ThreadPool* pool) {
+    StreamHeader header;
+    const BlockEntry* table;
+    const uint8_t* blocks;
+    size_t blocksSize;
+    if (!readHeader(data, size, INDEX_MAGIC, header, table, blocks, blocksSize)) return false;
+    if (header.blockCount != ((size_t)header.count + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE) return false;
+
+    return forEachBlock(header.blockCount, pool, [&](uint32_t block) {
+        BlockEntry entry;
+        std::memcpy(&entry, &table[block], sizeof(entry));
+        size_t first = (size_t)block * INDEX_BLOCK_SIZE;
+        size_t n = std::min<size_t>(INDEX_BLOCK_SIZE, header.count - first);
+        const uint8_t* ptr = blocks + entry.offset;
+        const uint8_t* end = ptr + entry.size;
+
+        thread_local std::vector<uint8_t> scratch;
+        if (header.flags & FLAG_ZERO_RUNS) {
+            // varints take at most 5 bytes each
+            scratch.resize(n * 5);
+            size_t written;
+            if (!decodeZeroRuns(ptr, end, scratch.data(), scratch.size(), written)) return false;
+            ptr = scratch.data();
+            end = ptr + written;
+        }
+
+        uint32_t* out = dst + first;
+        uint32_t prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t value;
+            if (!readVarint(ptr, end, value)) return false;
+            prev += (uint32_t)unzigzag(value);
+            out[i] = prev;
+        }
+        return ptr == end;
+    });
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// compact encoding for cached vertex and index data
+//
+// streams are split into independent blocks listed in a header table, so any block can be
+// decoded on its own and a whole mesh can be decompressed in parallel straight into its
+// destination, e.g. a mapped gl buffer.
+//  - vertices: each block is transposed into byte planes (byte k of every vertex together) and
+//    every plane is delta coded against the previous vertex, which turns smooth attributes into
+//    long runs of small values
+//  - indices: delta from the previous index, zigzag mapped and written as varints
+//  - optional zero-run stage on top of either, which collapses the runs left by delta coding
+
+constexpr uint32_t VERTEX_BLOCK_SIZE = 8192; // vertices per block
+constexpr uint32_t INDEX_BLOCK_SIZE = 32768; // indices per block
+
+void encodeVertices(const void* vertices, size_t count, size_t stride, bool zeroRuns, std::vector<uint8_t>& out);
+void encodeIndices(const uint32_t* indices, size_t count, bool zeroRuns, std::vector<uint8_t>& out);
+
+// element count and stride of an encoded stream, false if the header is invalid
+bool encodedVertexInfo(const uint8_t* data, size_t size, size_t& count, size_t& stride);
+bool encodedIndexCount(const uint8_t* data, size_t size, size_t& count);
+
+// dst must hold count * stride bytes (count indices), blocks run on the pool when one is given
+bool decodeVertices(const uint8_t* data, size_t size, void* dst, ThreadPool* pool = nullptr);
+bool decodeIndices(const uint8_t* data, size_t size, uint32_t* dst, ThreadPool* pool = nullptr);
\ No newline at end of file
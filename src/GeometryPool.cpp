@@ -0,0 +1,53 @@
+#include "GeometryPool.h"
+#include "Model.h"
+#include "GLState.h"
+
+static_assert(sizeof(Vertex) == 22 * sizeof(float), "Vertex must match VERTEX_FLOATS in model.vert");
+
+GeometryPool::~GeometryPool() {
+    release();
+}
+
+void GeometryPool::build(const Model& model) {
+    release();
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (const Mesh& mesh : model.meshes) {
+        ranges.emplace(&mesh, Range{ (uint32_t)indices.size(), (uint32_t)mesh.indices.size(), (int32_t)vertices.size() });
+        vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+    }
+    if (vertices.empty() || indices.empty()) return;
+
+    bytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+    glCreateBuffers(1, &vertexBuffer);
+    glNamedBufferStorage(vertexBuffer, vertices.size() * sizeof(Vertex), vertices.data(), 0);
+    glCreateBuffers(1, &indexBuffer);
+    glNamedBufferStorage(indexBuffer, indices.size() * sizeof(unsigned int), indices.data(), 0);
+
+    // no attributes, only the index buffer
+    glCreateVertexArrays(1, &vertexArray);
+    glVertexArrayElementBuffer(vertexArray, indexBuffer);
+}
+
+void GeometryPool::release() {
+    ranges.clear();
+    bytes = 0;
+    if (!vertexArray) return;
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    vertexArray = vertexBuffer = indexBuffer = 0;
+    GLState::invalidate();
+}
+
+void GeometryPool::bind() const {
+    GLState::bindVertexArray(vertexArray);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, vertexBuffer);
+}
+
+const GeometryPool::Range* GeometryPool::find(const Mesh& mesh) const {
+    auto it = ranges.find(&mesh);
+    return it != ranges.end() && vertexArray ? &it->second : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+class Model;
+
+// layout of DrawElementsIndirectCommand, as read from GL_DRAW_INDIRECT_BUFFER, mirrored in scene.glsl
+struct DrawCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+static_assert(sizeof(DrawCommand) == 20);
+
+// every mesh's vertices and indices packed into one storage buffer and one index buffer for
+// programmable vertex pulling. programs built with VERTEX_PULLING fetch and decode vertices
+// themselves by gl_VertexID (see model.vert), so all meshes share a single vertex array and
+// can be merged into one multi-draw whatever their vertex format
+class GeometryPool {
+public:
+    static constexpr uint32_t BINDING = 2; // vertex ssbo binding point used by model.vert
+
+    struct Range {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t baseVertex;
+    };
+
+    ~GeometryPool();
+
+    // meshes are keyed by address, so rebuild whenever the model's meshes are replaced
+    void build(const Model& model);
+    void release();
+    // the shared vertex array and the vertex storage buffer
+    void bind() const;
+
+    // nullptr if the mesh was not part of the last build
+    const Range* find(const Mesh& mesh) const;
+    DrawCommand commandFor(const Range& range) const { return { range.indexCount, 1, range.firstIndex, range.baseVertex, 0 }; }
+    size_t getBytes() const { return bytes; }
+
+private:
+    uint32_t vertexArray = 0;
+    uint32_t vertexBuffer = 0;
+    uint32_t indexBuffer = 0;
+    size_t bytes = 0;
+    std::unordered_map<const Mesh*, Range> ranges;
+};
\ No newline at end of file
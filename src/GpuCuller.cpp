@@ -0,0 +1,57 @@
+#include "GpuCuller.h"
+#include "GLState.h"
+
+#include <algorithm>
+
+GpuCuller::GpuCuller(const AssetCache* cache) : program("shaders/cull.comp", cache) {}
+
+GpuCuller::~GpuCuller() {
+    if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    if (drawBuffer) glDeleteBuffers(1, &drawBuffer);
+    if (countBuffer) glDeleteBuffers(1, &countBuffer);
+}
+
+bool GpuCuller::cull(const BufferRange& commands, const BufferRange& draws, uint32_t candidateCount, uint32_t batchCount) {
+    if (!program.isReady() || candidateCount == 0) return false;
+    reserve(candidateCount, batchCount);
+
+    uint32_t zero = 0;
+    glClearNamedBufferSubData(countBuffer, GL_R32UI, 0, batchCount * sizeof(uint32_t), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, CANDIDATE_COMMANDS_BINDING, commands.buffer, commands.offset, commands.size);
+    GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, CANDIDATE_DRAWS_BINDING, draws.buffer, draws.offset, draws.size);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_DRAWS_BINDING, drawBuffer);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BATCH_COUNTS_BINDING, countBuffer);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_COMMANDS_BINDING, commandBuffer);
+
+    program.use();
+    program.setInt("candidateCount", (int)candidateCount);
+    glDispatchCompute((candidateCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    // the commands and counts are read by the draws, the draw data by their vertex shaders
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    GLState::bindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+    return true;
+}
+
+// gpu only storage, grown to the largest frame seen so far
+void GpuCuller::reserve(size_t drawCount, size_t batchCount) {
+    if (drawCount > drawCapacity) {
+        drawCapacity = std::max(drawCount, drawCapacity * 2);
+        if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+        if (drawBuffer) glDeleteBuffers(1, &drawBuffer);
+        glCreateBuffers(1, &commandBuffer);
+        glNamedBufferStorage(commandBuffer, drawCapacity * sizeof(DrawCommand), nullptr, 0);
+        glCreateBuffers(1, &drawBuffer);
+        glNamedBufferStorage(drawBuffer, drawCapacity * sizeof(DrawData), nullptr, 0);
+        GLState::invalidate();
+    }
+    if (batchCount > batchCapacity) {
+        batchCapacity = std::max(batchCount, batchCapacity * 2);
+        if (countBuffer) glDeleteBuffers(1, &countBuffer);
+        glCreateBuffers(1, &countBuffer);
+        glNamedBufferStorage(countBuffer, batchCapacity * sizeof(uint32_t), nullptr, 0);
+        GLState::invalidate();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "GeometryPool.h"
+#include "RenderQueue.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// frustum culls the draws of the vertex pulling path on the gpu (shaders/cull.comp). every
+// candidate is tested against its scene object's bounds and the ViewConstants camera, and the
+// survivors are appended to their batch's range of an output command buffer with a per-batch
+// count, which glMultiDrawElementsIndirectCount consumes without a cpu readback. draw order
+// within a batch is whatever order the survivors were appended in
+class GpuCuller {
+public:
+    // ssbo bindings of cull.comp, chosen so the feedback and scene bindings stay intact
+    static constexpr uint32_t CANDIDATE_COMMANDS_BINDING = 1;
+    static constexpr uint32_t CANDIDATE_DRAWS_BINDING = 2;
+    static constexpr uint32_t VISIBLE_DRAWS_BINDING = DrawData::BINDING; // stays bound for the draws
+    static constexpr uint32_t BATCH_COUNTS_BINDING = 4;
+    static constexpr uint32_t VISIBLE_COMMANDS_BINDING = 6;
+    static constexpr uint32_t GROUP_SIZE = 64; // local_size_x of cull.comp
+
+    GpuCuller(const AssetCache* cache = nullptr);
+    ~GpuCuller();
+
+    // compute program hot reload, see ShaderProgram
+    void poll() { program.poll(); }
+    bool usesFile(const std::string& path) const { return program.usesFile(path); }
+    void reload() { program.reload(); }
+
+    // cull the candidates, whose DrawData carries their batch and its first draw. on success the
+    // visible draws are bound at DrawData::BINDING, the commands as GL_DRAW_INDIRECT_BUFFER and the
+    // counts as GL_PARAMETER_BUFFER, false if the program is not ready
+    bool cull(const BufferRange& commands, const BufferRange& draws, uint32_t candidateCount, uint32_t batchCount);
+
+    // offsets of a batch into the bound command and parameter buffers
+    static size_t commandOffset(uint32_t first) { return first * sizeof(DrawCommand); }
+    static size_t countOffset(uint32_t batch) { return batch * sizeof(uint32_t); }
+
+private:
+    ShaderProgram program;
+    uint32_t commandBuffer = 0, drawBuffer = 0, countBuffer = 0;
+    size_t drawCapacity = 0, batchCapacity = 0;
+
+    void reserve(size_t drawCount, size_t batchCount);
+};
\ No newline at end of file
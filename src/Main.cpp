@@ -16,8 +16,25 @@
 
 #include "Window.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
 #include "Camera.h"
 #include "Model.h"
+#include "TextureFeedback.h"
+#include "UploadQueue.h"
+#include "FileWatcher.h"
+#include "AssetCache.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "FrameConstants.h"
+#include "RenderQueue.h"
+#include "MaterialTable.h"
+#include "GLState.h"
+#include "FrameSync.h"
+#include "RingBuffer.h"
+#include "GeometryPool.h"
+#include "SceneBuffer.h"
+#include "GpuCuller.h"
+#include "RenderThread.h"
 
 #include <cstdlib>
 #include <iostream>
@@ -38,16 +55,36 @@ int main(int argc, char** argv) {
 
 	Window* window = new Window();
 
-	ShaderProgram shaders("shaders/model.vert", "shaders/model.frag");
+	AssetCache cache("cache");
+	MaterialTable* materials = new MaterialTable();
+	// vertices are pulled from one pool and each program's draws merged into a multi-draw
+	bool vertexPulling = true;
+	GeometryPool* geometry = vertexPulling ? new GeometryPool() : nullptr;
+	GpuCuller* culler = vertexPulling ? new GpuCuller(&cache) : nullptr;
+	std::vector<std::string> defines = { materials->getDefine() };
+	if (vertexPulling) defines.push_back("VERTEX_PULLING");
+	ShaderVariants shaders("shaders/model.vert", "shaders/model.frag", &cache, defines);
+	shaders.addLinkCallback([](ShaderProgram& program) { ConstantBuffers::validate(program); });
+	// extra copies go through Model::DrawInstanced, which needs variants that read vertex attributes
+	ShaderVariants instancedShaders("shaders/model.vert", "shaders/model.frag", &cache, { materials->getDefine() });
+	instancedShaders.addLinkCallback([](ShaderProgram& program) { ConstantBuffers::validate(program); });
+	TextureFeedback* feedback = new TextureFeedback();
+	UploadQueue* uploads = new UploadQueue();
+	// the cpu may run at most this many frames ahead of the gpu
+	FrameSync* sync = new FrameSync(2);
+	RingBuffer* ring = new RingBuffer(1 << 20, *sync); // per frame in flight
+	ConstantBuffers constants(*ring);
+	SceneBuffer* scene = new SceneBuffer(*ring);
 
 	registerInputActions(window);
 	window->setCursorVis(false);
 
 	bool drawWireframes = false;
+	bool gpuCulling = true;
 	
 	// set opengl state
 	glClearColor(0.0f, 0.0f, 0.0f, 1.f);
-	glEnable(GL_DEPTH_TEST);
+	GLState::setEnabled(GL_DEPTH_TEST, true);
 
 	initImgui(window);
 
@@ -62,7 +99,142 @@ int main(int argc, char** argv) {
 	// load models
 	glClear(GL_COLOR_BUFFER_BIT);
 	glfwSwapBuffers(window->wnd);
-	Model backpack("assets/models/SpaceStation/Space Station Scene.obj");
+	ThreadPool workers;
+	Model backpack("assets/models/SpaceStation/Space Station Scene.obj", uploads, &cache, &workers);
+	backpack.prepareVariants(shaders);
+	backpack.prepareVariants(instancedShaders);
+
+	// draws are sorted by state and depth each frame
+	materials->build(backpack);
+	if (geometry) geometry->build(backpack);
+	RenderQueue queue;
+	queue.maxDepth = 1000.0f; // far plane
+	queue.materials = materials;
+	queue.geometry = geometry;
+	queue.ring = ring;
+	queue.scene = scene;
+
+	// object transforms live on the gpu, only changes are uploaded
+	glm::mat4 model = glm::mat4(1.0f);
+	backpack.addToScene(*scene, model);
+
+	// hot reload changed shaders, textures and meshes
+	FileWatcher watcher;
+	watcher.watch("assets");
+	watcher.watch("shaders");
+	watcher.addCallback([&](const std::string& path) {
+		bool isShader = shaders.usesFile(path) || instancedShaders.usesFile(path) || (culler && culler->usesFile(path));
+		if (shaders.usesFile(path)) shaders.reload(path);
+		if (instancedShaders.usesFile(path)) instancedShaders.reload(path);
+		if (culler && culler->usesFile(path)) culler->reload();
+		if (!isShader) {
+			// only what the change touched is rebuilt, files the model does not use cost nothing
+			Model::FileChange change = backpack.onFileChanged(path);
+			// materials may need new variants, a texture that loads for the first time adds a feature
+			if (change.meshes || change.texture) {
+				backpack.prepareVariants(shaders);
+				backpack.prepareVariants(instancedShaders);
+			}
+			if (change.texture) materials->refreshTexture(change.texture);
+			if (change.meshes || change.texture) materials->refresh(backpack);
+			backpack.releaseRetiredTextures();
+			if (change.meshes) {
+				if (geometry) geometry->build(backpack);
+				backpack.addToScene(*scene, model);
+			}
+		}
+	});
+
+	std::vector<glm::mat4> copyTransforms;
+
+	// all gl work from here on happens on the render thread, each frame draws from a snapshot
+	// published by the main loop below
+	auto render = [&](RenderSnapshot& snap, RenderStats& stats) {
+		watcher.poll();
+		// pick up programs once the driver has linked them
+		shaders.poll();
+		instancedShaders.poll();
+		if (culler) culler->poll();
+
+		// blocks until the gpu has finished the frame that last used this slot
+		sync->setFramesInFlight(snap.framesInFlight);
+		sync->beginFrame();
+
+		// clear screen and set draw mode
+		glViewport(0, 0, snap.framebufferWidth, snap.framebufferHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		GLState::polygonMode(snap.drawWireframes ? GL_LINE : GL_FILL);
+		feedback->enabled = snap.feedbackEnabled;
+
+		// per-frame data is written straight into the ring, shared constants first
+		ring->beginFrame();
+		FrameConstants frame = {};
+		frame.lightPos = glm::vec3(0.0f);
+		frame.heightScale = 0.0f;
+		frame.time = (float)snap.time;
+		frame.deltaTime = (float)snap.deltaTime;
+		frame.feedbackEnabled = feedback->enabled;
+		constants.update(frame);
+		constants.update(snap.view);
+
+		model = snap.model;
+		backpack.setTransform(*scene, model);
+		scene->upload();
+
+		// stream in pending textures, nearest and visible first
+		backpack.prioritizeUploads(snap.view.viewPos, model, feedback->enabled ? feedback : nullptr);
+		uploads->process();
+		materials->update(uploads);
+
+		feedback->beginFrame();
+		queue.clear();
+		queue.culler = snap.gpuCulling ? culler : nullptr;
+		backpack.enqueue(queue, shaders, model, snap.view.viewPos);
+		queue.sort();
+		queue.execute();
+
+		// copies in a row behind the model, one instanced call per mesh
+		if (snap.instancedCopies > 0) {
+			glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+			for (const Mesh& mesh : backpack.meshes) {
+				boundsMin = glm::min(boundsMin, mesh.boundsMin);
+				boundsMax = glm::max(boundsMax, mesh.boundsMax);
+			}
+			float spacing = (boundsMax.x - boundsMin.x) * 1.2f;
+			copyTransforms.clear();
+			for (uint32_t i = 1; i <= snap.instancedCopies; i++)
+				copyTransforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(spacing * i, 0.0f, 0.0f)) * model);
+			materials->bind();
+			backpack.DrawInstanced(instancedShaders, copyTransforms, *ring);
+		}
+		feedback->endFrame();
+		ring->endFrame();
+
+		// render imgui on top of scene
+		ImGui_ImplOpenGL3_RenderDrawData(&snap.imgui);
+		GLState::invalidate();
+		sync->endFrame();
+
+		Profiler::endFrame();
+		for (size_t i = 0; i < (size_t)Profiler::Stat::Count; i++)
+			stats.profiler[i] = Profiler::get((Profiler::Stat)i);
+		stats.sampledTextures = feedback->getSampledCount();
+		stats.shaderVariants = shaders.getCount();
+		stats.bindless = materials->getMode() == MaterialTable::Mode::Bindless;
+		stats.geometryBytes = geometry ? geometry->getBytes() : 0;
+		stats.uploadDepth = uploads->getDepth();
+		stats.uploadBytes = uploads->getBytesLastFrame();
+		stats.uploadMs = uploads->getMsLastFrame();
+		stats.ringUsed = ring->getUsedLastFrame();
+		stats.ringBytes = ring->getFrameBytes();
+		stats.sceneObjects = scene->getCount();
+		stats.sceneBytes = scene->getBytesLastFrame();
+	};
+	glfwMakeContextCurrent(nullptr);
+	RenderThread* renderer = new RenderThread(window->wnd, render);
+	bool feedbackEnabled = false;
+	int framesInFlight = (int)sync->getFramesInFlight();
+	int instancedCopies = 0;
 
 	// main loop
 	while (!glfwWindowShouldClose(window->wnd)) {
@@ -71,13 +243,17 @@ int main(int argc, char** argv) {
 		simLag += deltaTime;
 		prevTime = currentTime;
 
+		// poll/process events
+		glfwPollEvents();
+		window->inputManager->processActions();
+
 		while (simLag >= simDelta) {
 			simLag -= simDelta;
 			// update sim here
 		}
 
-		// layout imgui frame
-		ImGui_ImplOpenGL3_NewFrame();
+		// layout imgui frame, stats lag the layout by the frames in flight
+		RenderStats stats = renderer->getStats();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 		ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
@@ -90,40 +266,65 @@ int main(int argc, char** argv) {
 		ImGui::Text("Frame Time: %.3f ms", deltaTime * 1000.0);
 		ImGui::Text("FPS: %.1f", deltaTime > 0.0 ? 1.0 / deltaTime : 0.0);
 		ImGui::Text("Window Size: %dx%d", window->getWidth(), window->getHeight());
+		ImGui::Text("Snapshot Wait: %.3f ms", renderer->getWaitMs());
 		ImGui::Separator();
 		ImGui::Checkbox("Draw Wireframes", &drawWireframes);
+		ImGui::SliderInt("Frames In Flight", &framesInFlight, 1, (int)FrameSync::MAX_FRAMES_IN_FLIGHT);
+		ImGui::SliderInt("Instanced Copies", &instancedCopies, 0, 64);
+		if (culler) ImGui::Checkbox("GPU Culling", &gpuCulling);
+		ImGui::Checkbox("Texture Feedback", &feedbackEnabled);
+		if (feedbackEnabled)
+			ImGui::Text("Sampled Textures: %u", stats.sampledTextures);
+		ImGui::Separator();
+		ImGui::Text("Shader Variants: %zu", stats.shaderVariants);
+		ImGui::Text("Materials: %s", stats.bindless ? "bindless" : "texture arrays");
+		if (geometry) ImGui::Text("Geometry Pool: %.1f MB", stats.geometryBytes / (1024.0 * 1024.0));
+		else ImGui::Text("Geometry Pool: off");
+		ImGui::Text("Upload Queue: %zu pieces", stats.uploadDepth);
+		ImGui::Text("Uploaded: %.1f KB in %.3f ms", stats.uploadBytes / 1024.0, stats.uploadMs);
+		ImGui::Text("Ring Buffer: %.1f / %.1f KB", stats.ringUsed / 1024.0, stats.ringBytes / 1024.0);
+		ImGui::Text("Scene: %zu objects, %.1f KB uploaded", stats.sceneObjects, stats.sceneBytes / 1024.0);
+		ImGui::Separator();
+		for (size_t i = 0; i < (size_t)Profiler::Stat::Count; i++) {
+			Profiler::Stat stat = (Profiler::Stat)i;
+			if (Profiler::isTime(stat)) ImGui::Text("%s: %.3f ms", Profiler::getName(stat), stats.profiler[i]);
+			else ImGui::Text("%s: %.0f", Profiler::getName(stat), stats.profiler[i]);
+		}
 		ImGui::End();
-
-		// clear screen and set draw mode
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glPolygonMode(GL_FRONT_AND_BACK, drawWireframes ? GL_LINE : GL_FILL);
-
-		shaders.use();
-
-		glm::mat4 projection = glm::perspective(glm::radians(camera.getZoom()),
-			(float)window->getWidth() / (float)window->getHeight(), 0.1f, 1000.0f);
-		shaders.setMat4("projection", projection);
-		glm::mat4 view = camera.getViewMatrix();
-		shaders.setMat4("view", view);
-
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
-		shaders.setMat4("model", model);
-
-		backpack.Draw(shaders);
-
-		// render imgui on top of scene
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-		// swap buffers and poll/process events
-		glfwSwapBuffers(window->wnd);
-		glfwPollEvents();
-		window->inputManager->processActions();
+		// hand the frame to the render thread, blocks only if it is a whole frame behind
+		RenderSnapshot& snap = renderer->beginSnapshot();
+		snap.time = currentTime;
+		snap.deltaTime = deltaTime;
+		glfwGetFramebufferSize(window->wnd, &snap.framebufferWidth, &snap.framebufferHeight);
+		snap.view.projection = glm::perspective(glm::radians(camera.getZoom()),
+			(float)window->getWidth() / (float)window->getHeight(), 0.1f, 1000.0f);
+		snap.view.view = camera.getViewMatrix();
+		snap.view.viewProjection = snap.view.projection * snap.view.view;
+		snap.view.viewPos = camera.getPosition();
+		snap.model = glm::scale(glm::mat4(1.0f), glm::vec3(0.8f, 0.8f, 0.8f));
+		snap.drawWireframes = drawWireframes;
+		snap.gpuCulling = gpuCulling;
+		snap.feedbackEnabled = feedbackEnabled;
+		snap.framesInFlight = (uint32_t)framesInFlight;
+		snap.instancedCopies = (uint32_t)instancedCopies;
+		snap.copyImGui(ImGui::GetDrawData());
+		renderer->publish();
 	}
 
-	// cleanup
+	// cleanup, the context is current on this thread again once the renderer is gone
+	delete renderer;
 	cleanupImgui();
+	queue.release();
+	delete scene;
+	delete ring;
+	delete sync;
+	delete geometry;
+	delete culler;
+	delete materials;
+	delete uploads;
+	delete feedback;
 	delete window;
 	return 0;
 }
@@ -205,6 +406,8 @@ void initImgui(Window* window) {
 	ImGui::StyleColorsDark();
 	ImGui_ImplGlfw_InitForOpenGL(window->wnd, true);
 	ImGui_ImplOpenGL3_Init("#version 460");
+	// creates the device objects and font texture while the context is still current here
+	ImGui_ImplOpenGL3_NewFrame();
 }
 
 void cleanupImgui() {
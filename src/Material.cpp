@@ -0,0 +1,34 @@
+#include "Material.h"
+#include "ShaderVariants.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+
+bool Material::roleFromType(const std::string& type, TextureRole& role) {
+    if (type == "texture_diffuse") role = TextureRole::Diffuse;
+    else if (type == "texture_specular") role = TextureRole::Specular;
+    else if (type == "texture_normal") role = TextureRole::Normal;
+    else if (type == "texture_height") role = TextureRole::Height;
+    else return false;
+    return true;
+}
+
+void Material::setTexture(TextureRole role, uint32_t texture) {
+    uint32_t& slot = textures[(size_t)role];
+    if (!slot) slot = texture;
+}
+
+void Material::finalize() {
+    static constexpr uint32_t ROLE_FEATURES[(size_t)TextureRole::Count] = {
+        HAS_DIFFUSE_MAP, HAS_SPECULAR_MAP, HAS_NORMAL_MAP, HAS_PARALLAX
+    };
+    features = 0;
+    for (size_t i = 0; i < (size_t)TextureRole::Count; i++)
+        if (textures[i]) features |= ROLE_FEATURES[i];
+}
+
+void Material::bind() const {
+    for (size_t i = 0; i < (size_t)TextureRole::Count; i++) {
+        if (textures[i]) GLState::bindTextureUnit((uint32_t)i, textures[i]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// what a texture is used for, doubles as the texture unit it is bound to (see model.frag)
+enum class TextureRole : uint32_t {
+    Diffuse,
+    Specular,
+    Normal,
+    Height,
+    Count
+};
+
+// a mesh's textures resolved once at load to the unit each binds to, so drawing needs no string
+// work. the owning Model gives materials with identical textures a shared id, which draws can be
+// sorted and batched by
+struct Material {
+    uint32_t id = 0;
+    uint32_t features = 0; // MaterialFeature bits, selects the shader variant
+    uint32_t textures[(size_t)TextureRole::Count] = {}; // gl texture per role, 0 if unused
+
+    // role for a Texture::type such as "texture_diffuse", false for types the shader does not use
+    static bool roleFromType(const std::string& type, TextureRole& role);
+
+    // set a role's texture, the first one set for a role is kept
+    void setTexture(TextureRole role, uint32_t texture);
+    // derive features once all textures are set
+    void finalize();
+    void bind() const;
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "MaterialTable.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static_assert(sizeof(MaterialTable::Record) == 64, "Record must match the std430 layout of MaterialRecord");
+
+MaterialTable::MaterialTable() {
+    mode = GLExtensions::bindlessTexture ? Mode::Bindless : Mode::Arrays;
+}
+
+MaterialTable::~MaterialTable() {
+    release();
+}
+
+const char* MaterialTable::getDefine() const {
+    return mode == Mode::Bindless ? "MATERIAL_BINDLESS" : "MATERIAL_ARRAYS";
+}
+
+void MaterialTable::build(const Model& model) {
+    release();
+
+    uint32_t maxId = 0;
+    for (const Mesh& mesh : model.meshes)
+        maxId = std::max(maxId, mesh.material.id);
+
+    Record empty = {};
+    for (auto& slot : empty.slots) slot[0] = slot[1] = -1;
+    records.assign(maxId + 1, empty);
+    recordTextures.assign(maxId + 1, {});
+    for (const Mesh& mesh : model.meshes)
+        writeRecord(mesh.material);
+
+    // one array per group, now that the layer counts are known
+    for (uint32_t i = 0; i < arrays.size(); i++) {
+        ArrayGroup& group = arrays[i];
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &group.texture);
+        glTextureStorage3D(group.texture, group.levels, group.format, group.width, group.height, (GLsizei)group.sources.size());
+        glTextureParameteri(group.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(group.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(group.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(group.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        for (uint32_t layer = 0; layer < group.sources.size(); layer++)
+            pendingCopies.push_back({ i, layer });
+    }
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, records.size() * sizeof(Record), records.data(), GL_DYNAMIC_STORAGE_BIT);
+}
+
+void MaterialTable::refresh(const Model& model) {
+    uint32_t maxId = 0;
+    for (const Mesh& mesh : model.meshes)
+        maxId = std::max(maxId, mesh.material.id);
+    if (!buffer || maxId + 1 != records.size()) {
+        build(model);
+        return;
+    }
+
+    std::vector<const Material*> changed;
+    for (const Mesh& mesh : model.meshes) {
+        const Material& material = mesh.material;
+        if (std::equal(std::begin(material.textures), std::end(material.textures), recordTextures[material.id].begin())) continue;
+        // array storage is immutable, a texture without a layer needs new arrays
+        if (mode == Mode::Arrays) {
+            for (uint32_t texture : material.textures) {
+                if (texture && !slots.count(texture)) {
+                    build(model);
+                    return;
+                }
+            }
+        }
+        writeRecord(material);
+        changed.push_back(&material);
+    }
+    if (changed.empty()) return;
+
+    for (const Material* material : changed)
+        glNamedBufferSubData(buffer, material->id * sizeof(Record), sizeof(Record), &records[material->id]);
+
+    // handles of textures no record uses anymore, before the model deletes them
+    if (mode == Mode::Bindless) {
+        for (auto it = handles.begin(); it != handles.end();) {
+            bool used = false;
+            for (const auto& textures : recordTextures)
+                used |= std::find(textures.begin(), textures.end(), it->first) != textures.end();
+            if (used) {
+                ++it;
+                continue;
+            }
+            GLExtensions::glMakeTextureHandleNonResidentARB(it->second);
+            it = handles.erase(it);
+        }
+    }
+}
+
+void MaterialTable::refreshTexture(uint32_t texture) {
+    auto it = slots.find(texture);
+    if (it == slots.end() || it->second.first < 0) return;
+    pendingCopies.push_back({ (uint32_t)it->second.first, (uint32_t)it->second.second });
+}
+
+void MaterialTable::release() {
+    for (auto& [texture, handle] : handles)
+        GLExtensions::glMakeTextureHandleNonResidentARB(handle);
+    handles.clear();
+    for (ArrayGroup& group : arrays)
+        glDeleteTextures(1, &group.texture);
+    arrays.clear();
+    slots.clear();
+    pendingCopies.clear();
+    records.clear();
+    recordTextures.clear();
+    if (buffer) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    GLState::invalidate();
+}
+
+void MaterialTable::update(const UploadQueue* uploads) {
+    for (size_t i = 0; i < pendingCopies.size();) {
+        auto [array, layer] = pendingCopies[i];
+        ArrayGroup& group = arrays[array];
+        uint32_t source = group.sources[layer];
+        if (uploads && uploads->isPending(source)) {
+            i++;
+            continue;
+        }
+
+        // whole mip chain, which the upload queue generated once the last band arrived
+        for (int level = 0; level < group.levels; level++) {
+            int width = std::max(1, group.width >> level), height = std::max(1, group.height >> level);
+            glCopyImageSubData(source, GL_TEXTURE_2D, level, 0, 0, 0,
+                group.texture, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+        }
+        pendingCopies[i] = pendingCopies.back();
+        pendingCopies.pop_back();
+    }
+}
+
+void MaterialTable::bind() const {
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffer);
+    for (uint32_t i = 0; i < arrays.size(); i++)
+        GLState::bindTextureUnit(FIRST_ARRAY_UNIT + i, arrays[i].texture);
+}
+
+void MaterialTable::writeRecord(const Material& material) {
+    Record& record = records[material.id];
+    record = {};
+    for (auto& slot : record.slots) slot[0] = slot[1] = -1;
+    std::copy(std::begin(material.textures), std::end(material.textures), recordTextures[material.id].begin());
+
+    for (size_t role = 0; role < (size_t)TextureRole::Count; role++) {
+        uint32_t texture = material.textures[role];
+        if (!texture) continue;
+        // no handle or layer can be made for a texture without storage, the role samples nothing
+        GLint immutable = 0;
+        glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+        if (!immutable) continue;
+        if (mode == Mode::Bindless) {
+            record.handles[role] = handleFor(texture);
+        }
+        else {
+            auto [array, layer] = slotFor(texture);
+            record.slots[role][0] = array;
+            record.slots[role][1] = layer;
+        }
+    }
+}
+
+uint64_t MaterialTable::handleFor(uint32_t texture) {
+    auto it = handles.find(texture);
+    if (it != handles.end()) return it->second;
+
+    // the texture's sampling state is frozen from here on, its contents can still be uploaded
+    uint64_t handle = GLExtensions::glGetTextureHandleARB(texture);
+    GLExtensions::glMakeTextureHandleResidentARB(handle);
+    handles.emplace(texture, handle);
+    return handle;
+}
+
+std::pair<int32_t, int32_t> MaterialTable::slotFor(uint32_t texture) {
+    auto it = slots.find(texture);
+    if (it != slots.end()) return it->second;
+
+    int width = 0, height = 0, format = 0, levels = 0;
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+    glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+
+    std::pair<int32_t, int32_t> slot = { -1, -1 };
+    for (uint32_t i = 0; i < arrays.size(); i++) {
+        ArrayGroup& group = arrays[i];
+        if (group.width == width && group.height == height && group.levels == levels && group.format == (GLenum)format) {
+            slot = { (int32_t)i, (int32_t)group.sources.size() };
+            group.sources.push_back(texture);
+            break;
+        }
+    }
+    if (slot.first < 0) {
+        if (arrays.size() < MAX_ARRAYS) {
+            slot = { (int32_t)arrays.size(), 0 };
+            arrays.push_back({ 0, width, height, levels, (GLenum)format, { texture } });
+        }
+        else fprintf(stderr, "Out of material arrays, texture %u (%dx%d) will sample as black\n", texture, width, height);
+    }
+    slots.emplace(texture, slot);
+    return slot;
+}
\ No newline at end of file
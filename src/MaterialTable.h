@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Model.h"
+#include "UploadQueue.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// every material's textures in one ssbo indexed by Material::id, so shaders look textures up
+// by id and switching materials binds nothing. with ARB_bindless_texture the records hold
+// resident texture handles, otherwise textures are copied into arrays grouped by size and format
+// and the records hold an array and layer per role
+class MaterialTable {
+public:
+    enum class Mode {
+        Bindless,
+        Arrays
+    };
+
+    static constexpr uint32_t BINDING = 1; // ssbo binding point used by model.frag
+    static constexpr uint32_t FIRST_ARRAY_UNIT = 4; // after the per-role units
+    static constexpr uint32_t MAX_ARRAYS = 8; // size of materialArrays in model.frag
+
+    // std430 mirror of MaterialRecord in model.frag
+    struct Record {
+        uint64_t handles[(size_t)TextureRole::Count];
+        int32_t slots[(size_t)TextureRole::Count][2]; // array index and layer, -1 if unused
+    };
+
+    MaterialTable();
+    ~MaterialTable();
+
+    Mode getMode() const { return mode; }
+    // define selecting the matching path in model.frag, for ShaderVariants
+    const char* getDefine() const;
+
+    // rebuild the records for every material of a model
+    void build(const Model& model);
+    // rewrite only the records whose textures changed since they were written. falls back to
+    // build when the material count changes or, with arrays, a texture has no layer yet
+    void refresh(const Model& model);
+    // copy a texture into its array layer again once its reloaded contents have uploaded
+    void refreshTexture(uint32_t texture);
+    // drop every handle, array and record, call before the textures they refer to are deleted
+    void release();
+    // copy textures whose upload has finished into their array layers
+    void update(const UploadQueue* uploads);
+    // bind the table (and arrays) for the draws that follow
+    void bind() const;
+
+private:
+    struct ArrayGroup {
+        uint32_t texture;
+        int width, height, levels;
+        GLenum format;
+        std::vector<uint32_t> sources; // layer i is copied from sources[i]
+    };
+
+    Mode mode;
+    uint32_t buffer = 0;
+    std::vector<Record> records;
+    std::vector<std::array<uint32_t, (size_t)TextureRole::Count>> recordTextures; // what each record was written from
+    std::unordered_map<uint32_t, uint64_t> handles; // resident handle of each texture
+    std::unordered_map<uint32_t, std::pair<int32_t, int32_t>> slots; // array slot of each texture
+    std::vector<ArrayGroup> arrays;
+    std::vector<std::pair<uint32_t, uint32_t>> pendingCopies; // array, layer
+
+    void writeRecord(const Material& material);
+    uint64_t handleFor(uint32_t texture);
+    std::pair<int32_t, int32_t> slotFor(uint32_t texture);
+};
\ No newline at end of file
@@ -1,69 +1,83 @@
 #include "Mesh.h"
+#include "Hash.h"
+#include "GLState.h"
+
+uint64_t MeshData::hash() const {
+    uint64_t hash = fnv1a(vertices.data(), vertices.size() * sizeof(Vertex));
+    hash = fnv1a(indices.data(), indices.size() * sizeof(unsigned int), hash);
+    for (const Texture& texture : textures) {
+        hash = fnv1a(texture.type, hash);
+        hash = fnv1a(texture.path, hash);
+    }
+    return hash;
+}
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
     : vertices(vertices), indices(indices), textures(textures) {
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
+    if (!this->vertices.empty()) {
+        boundsMin = boundsMax = this->vertices[0].Position;
+        for (const Vertex& v : this->vertices) {
+            boundsMin = glm::min(boundsMin, v.Position);
+            boundsMax = glm::max(boundsMax, v.Position);
+        }
+    }
+    for (const Texture& texture : this->textures) {
+        TextureRole role;
+        if (Material::roleFromType(texture.type, role)) material.setTexture(role, texture.id);
+    }
+    material.finalize();
     setupMesh();
 }
 
-void Mesh::Draw(ShaderProgram& shader) {
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
-    unsigned int normalNr = 1;
-    unsigned int heightNr = 1;
-    for (unsigned int i = 0; i < textures.size(); i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        // retrieve texture number (diffuse_textureN)
-        std::string number;
-        std::string name = textures[i].type;
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNr++);
-        else if (name == "texture_normal")
-            number = std::to_string(normalNr++);
-        else if (name == "texture_height")
-            number = std::to_string(heightNr++);
-
-        // set texture sampler and bind texture
-        glUniform1i(glGetUniformLocation(shader.id, (name + number).c_str()), i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
-    }
+void Mesh::Draw(ShaderProgram& shader, uint32_t instances) {
+    material.bind();
+    const uint32_t* ids = material.textures;
+    shader.setUVec4("feedbackTextureIds", glm::uvec4(ids[0], ids[1], ids[2], ids[3]));
 
     // draw model
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(VAO);
+    if (instances == 1) glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+    else glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0, (GLsizei)instances);
+}
 
-    glActiveTexture(GL_TEXTURE0);
+void Mesh::release() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    VAO = VBO = EBO = 0;
+    GLState::invalidate();
 }
 
 void Mesh::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    // immutable storage, filled at creation and never rebound to edit. empty storage is invalid,
+    // so an empty mesh keeps buffer 0 and its zero count draws read nothing
+    if (!vertices.empty()) {
+        glCreateBuffers(1, &VBO);
+        glNamedBufferStorage(VBO, vertices.size() * sizeof(Vertex), vertices.data(), 0);
+    }
+    if (!indices.empty()) {
+        glCreateBuffers(1, &EBO);
+        glNamedBufferStorage(EBO, indices.size() * sizeof(unsigned int), indices.data(), 0);
+    }
 
-    // vertex attribute pointers
-    glEnableVertexAttribArray(0); // positions
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(1); // normals
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    glEnableVertexAttribArray(2); // tex coords
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    glEnableVertexAttribArray(3); // tangents
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-    glEnableVertexAttribArray(4); // bitangents
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-    glEnableVertexAttribArray(5); // ids
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-    glEnableVertexAttribArray(6); // weights
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+    glCreateVertexArrays(1, &VAO);
+    glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(VAO, EBO);
 
-    glBindVertexArray(0);
+    // vertex attribute formats, all read from binding 0
+    auto attribute = [this](GLuint index, GLint size, GLenum type, size_t offset) {
+        glEnableVertexArrayAttrib(VAO, index);
+        if (type == GL_INT) glVertexArrayAttribIFormat(VAO, index, size, type, (GLuint)offset);
+        else glVertexArrayAttribFormat(VAO, index, size, type, GL_FALSE, (GLuint)offset);
+        glVertexArrayAttribBinding(VAO, index, 0);
+    };
+    attribute(0, 3, GL_FLOAT, offsetof(Vertex, Position)); // positions
+    attribute(1, 3, GL_FLOAT, offsetof(Vertex, Normal)); // normals
+    attribute(2, 2, GL_FLOAT, offsetof(Vertex, TexCoords)); // tex coords
+    attribute(3, 3, GL_FLOAT, offsetof(Vertex, Tangent)); // tangents
+    attribute(4, 3, GL_FLOAT, offsetof(Vertex, Bitangent)); // bitangents
+    attribute(5, 4, GL_INT, offsetof(Vertex, m_BoneIDs)); // ids
+    attribute(6, 4, GL_FLOAT, offsetof(Vertex, m_Weights)); // weights
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Shader.h"
+#include "ShaderVariants.h"
+#include "Material.h"
 #include <string>
 #include <vector>
 
@@ -26,15 +28,29 @@ struct Texture {
     std::string path;
 };
 
+// cpu-side result of importing one mesh, before any gl resources exist
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<Texture> textures;
+
+    // content hash used to detect which meshes changed between imports
+    uint64_t hash() const;
+};
+
 class Mesh {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
     unsigned int VAO;
+    glm::vec3 boundsMin, boundsMax; // object-space aabb
+    Material material; // textures resolved to their units, built from textures
 
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
-    void Draw(ShaderProgram& shader);
+    void Draw(ShaderProgram& shader, uint32_t instances = 1);
+    // free gl resources, meshes are copied around by value so this is not done in a destructor
+    void release();
 
 private:
     unsigned int VBO, EBO;
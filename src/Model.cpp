@@ -1,52 +1,385 @@
 #include "Model.h"
+#include "GeometryCodec.h"
+#include "GLState.h"
 #include <stb/stb_image.h>
 
-Model::Model(std::string const& path) {
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+// post-processing applied on import, part of the asset cache key
+static constexpr unsigned int IMPORT_FLAGS =
+    aiProcess_Triangulate |
+    aiProcess_GenSmoothNormals |
+    aiProcess_FlipUVs |
+    aiProcess_CalcTangentSpace;
+
+static constexpr uint32_t MESH_CACHE_MAGIC = 0x43484D4F; // "OMHC"
+
+// hash of the source file plus, for obj files, the material libraries it references
+static bool hashSource(const std::string& path, uint64_t& hash) {
+    if (!AssetCache::hashFile(path, hash)) return false;
+    if (std::filesystem::path(path).extension() != ".obj") return true;
+
+    std::ifstream file(path);
+    std::string line;
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    while (std::getline(file, line)) {
+        if (line.rfind("mtllib ", 0) != 0) continue;
+        std::string library = line.substr(7);
+        while (!library.empty() && (library.back() == '\r' || library.back() == ' ')) library.pop_back();
+        uint64_t libraryHash = 0;
+        if (AssetCache::hashFile((directory / library).string(), libraryHash))
+            hash = fnv1a(&libraryHash, sizeof(libraryHash), hash);
+    }
+    return true;
+}
+
+template <typename T>
+static void writeValue(std::vector<char>& out, const T& value) {
+    out.insert(out.end(), (const char*)&value, (const char*)&value + sizeof(T));
+}
+
+static void writeBytes(std::vector<char>& out, const void* data, size_t size) {
+    out.insert(out.end(), (const char*)data, (const char*)data + size);
+}
+
+static void writeString(std::vector<char>& out, const std::string& str) {
+    writeValue(out, (uint32_t)str.size());
+    writeBytes(out, str.data(), str.size());
+}
+
+// bounds-checked reader over a cache entry
+struct CacheReader {
+    const char* ptr;
+    const char* end;
+
+    bool read(void* dst, size_t size) {
+        if ((size_t)(end - ptr) < size) return false;
+        std::memcpy(dst, ptr, size);
+        ptr += size;
+        return true;
+    }
+    template <typename T>
+    bool read(T& value) { return read(&value, sizeof(T)); }
+    bool read(std::string& str) {
+        uint32_t size;
+        if (!read(size) || (size_t)(end - ptr) < size) return false;
+        str.assign(ptr, size);
+        ptr += size;
+        return true;
+    }
+};
+
+// layout: magic, mesh count, then per mesh the texture count, the encoded vertex and index
+// streams (see GeometryCodec) each prefixed with their size, and the texture references
+static std::vector<char> serializeMeshes(const std::vector<MeshData>& meshes) {
+    std::vector<char> out;
+    std::vector<uint8_t> encoded;
+    writeValue(out, MESH_CACHE_MAGIC);
+    writeValue(out, (uint32_t)meshes.size());
+    for (const MeshData& mesh : meshes) {
+        writeValue(out, (uint32_t)mesh.textures.size());
+        encoded.clear();
+        encodeVertices(mesh.vertices.data(), mesh.vertices.size(), sizeof(Vertex), true, encoded);
+        writeValue(out, (uint32_t)encoded.size());
+        writeBytes(out, encoded.data(), encoded.size());
+        encoded.clear();
+        encodeIndices(mesh.indices.data(), mesh.indices.size(), true, encoded);
+        writeValue(out, (uint32_t)encoded.size());
+        writeBytes(out, encoded.data(), encoded.size());
+        for (const Texture& texture : mesh.textures) {
+            writeString(out, texture.type);
+            writeString(out, texture.path);
+        }
+    }
+    return out;
+}
+
+// texture ids are left unresolved, only type and path are stored
+static bool deserializeMeshes(const std::vector<char>& data, std::vector<MeshData>& meshes, ThreadPool* pool) {
+    CacheReader reader = { data.data(), data.data() + data.size() };
+    uint32_t magic, meshCount;
+    if (!reader.read(magic) || magic != MESH_CACHE_MAGIC || !reader.read(meshCount)) return false;
+
+    // counts come from the file, so bound them by the bytes left before allocating
+    constexpr size_t MIN_MESH_BYTES = 3 * sizeof(uint32_t); // texture count and both stream sizes
+    constexpr size_t MIN_TEXTURE_BYTES = 2 * sizeof(uint32_t); // two empty strings
+    if (meshCount > (size_t)(reader.end - reader.ptr) / MIN_MESH_BYTES) return false;
+    meshes.resize(meshCount);
+    for (MeshData& mesh : meshes) {
+        uint32_t textureCount, vertexSize, indexSize;
+        if (!reader.read(textureCount) || !reader.read(vertexSize)) return false;
+        if ((size_t)(reader.end - reader.ptr) < vertexSize) return false;
+        const uint8_t* vertexData = (const uint8_t*)reader.ptr;
+        reader.ptr += vertexSize;
+        if (!reader.read(indexSize) || (size_t)(reader.end - reader.ptr) < indexSize) return false;
+        const uint8_t* indexData = (const uint8_t*)reader.ptr;
+        reader.ptr += indexSize;
+
+        // blocks of each stream are decoded in parallel straight into the mesh's storage
+        size_t vertexCount, stride, indexCount;
+        if (!encodedVertexInfo(vertexData, vertexSize, vertexCount, stride) || stride != sizeof(Vertex)) return false;
+        if (!encodedIndexCount(indexData, indexSize, indexCount)) return false;
+        mesh.vertices.resize(vertexCount);
+        mesh.indices.resize(indexCount);
+        if (!decodeVertices(vertexData, vertexSize, mesh.vertices.data(), pool)) return false;
+        if (!decodeIndices(indexData, indexSize, mesh.indices.data(), pool)) return false;
+
+        if (textureCount > (size_t)(reader.end - reader.ptr) / MIN_TEXTURE_BYTES) return false;
+        mesh.textures.resize(textureCount);
+        for (Texture& texture : mesh.textures)
+            if (!reader.read(texture.type) || !reader.read(texture.path)) return false;
+    }
+    return reader.ptr == reader.end;
+}
+
+Model::Model(std::string const& path, UploadQueue* uploads, AssetCache* cache, ThreadPool* pool)
+    : uploads(uploads), cache(cache), pool(pool) {
     loadModel(path);
 }
 
-void Model::Draw(ShaderProgram& shader) {
-    for (Mesh& mesh : meshes)
-        mesh.Draw(shader);
+void Model::Draw(ShaderVariants& shaders, const glm::mat4& transform) {
+    uint32_t current = 0;
+    for (Mesh& mesh : meshes) {
+        ShaderProgram& program = shaders.get(mesh.material.features);
+        if (!program.isReady()) continue;
+        if (program.id != current) {
+            program.use();
+            program.setBool("instanced", false);
+            current = program.id;
+        }
+        program.setMat4("model", transform);
+        program.setInt("materialId", (int)mesh.material.id);
+        mesh.Draw(program);
+    }
+}
+
+void Model::DrawInstanced(ShaderVariants& shaders, std::span<const glm::mat4> transforms, RingBuffer& ring, std::span<const uint8_t> visible) {
+    // entries of visible past the last transform have nothing to pack
+    size_t count = transforms.size();
+    if (!visible.empty()) {
+        std::span<const uint8_t> used = visible.first(std::min(visible.size(), transforms.size()));
+        count = (size_t)std::count_if(used.begin(), used.end(), [](uint8_t v) { return v != 0; });
+    }
+    if (count == 0) return;
+
+    RingBuffer::Allocation allocation = ring.allocateStorage(count * sizeof(glm::mat4));
+    if (!allocation.data) return;
+    glm::mat4* packed = (glm::mat4*)allocation.data;
+    for (size_t i = 0; i < transforms.size(); i++)
+        if (visible.empty() || (i < visible.size() && visible[i])) *packed++ = transforms[i];
+    GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, allocation.buffer, allocation.offset, allocation.size);
+
+    uint32_t current = 0;
+    for (Mesh& mesh : meshes) {
+        ShaderProgram& program = shaders.get(mesh.material.features);
+        if (!program.isReady()) continue;
+        if (program.id != current) {
+            program.use();
+            program.setBool("instanced", true);
+            current = program.id;
+        }
+        program.setInt("materialId", (int)mesh.material.id);
+        mesh.Draw(program, (uint32_t)count);
+    }
+}
+
+void Model::addToScene(SceneBuffer& scene, const glm::mat4& transform) {
+    for (uint32_t id : objectIds)
+        scene.remove(id);
+    objectIds.clear();
+    for (const Mesh& mesh : meshes) {
+        ObjectData object = {};
+        object.world = transform;
+        object.boundsMin = mesh.boundsMin;
+        object.materialId = mesh.material.id;
+        object.boundsMax = mesh.boundsMax;
+        objectIds.push_back(scene.add(object));
+    }
+}
+
+void Model::setTransform(SceneBuffer& scene, const glm::mat4& transform) {
+    for (uint32_t id : objectIds)
+        scene.setTransform(id, transform);
+}
+
+void Model::enqueue(RenderQueue& queue, ShaderVariants& shaders, const glm::mat4& transform, const glm::vec3& viewPos) const {
+    uint32_t transformIndex = queue.scene ? 0 : queue.addTransform(transform);
+    size_t count = queue.scene ? std::min(meshes.size(), objectIds.size()) : meshes.size();
+
+    // meshes are prepared on the worker threads, variants that were never asked for are skipped
+    // since building one needs the gl thread (see prepareVariants)
+    queue.record(pool, count, [&](size_t i, RenderQueue::Arena& arena) {
+        const Mesh& mesh = meshes[i];
+        ShaderProgram* program = shaders.find(mesh.material.features);
+        if (!program || !program->isReady()) return;
+        glm::vec3 center = glm::vec3(transform * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+        uint32_t object = queue.scene ? objectIds[i] : transformIndex;
+        arena.submit(RenderQueue::Pass::Opaque, *program, mesh, object, glm::distance(viewPos, center));
+    });
+}
+
+void Model::prepareVariants(ShaderVariants& shaders) const {
+    for (const Mesh& mesh : meshes)
+        shaders.get(mesh.material.features);
+}
+
+void Model::prioritizeUploads(const glm::vec3& viewPos, const glm::mat4& transform, const TextureFeedback* feedback) {
+    if (!uploads || uploads->getDepth() == 0) return;
+
+    // textures the gpu did not sample recently rank behind everything that it did
+    constexpr float UNSEEN_PENALTY = 1e6f;
+
+    // a texture shared by several meshes takes the priority of its closest one
+    glm::vec3 localViewPos = glm::vec3(glm::inverse(transform) * glm::vec4(viewPos, 1.0f));
+    std::unordered_map<unsigned int, float> priorities;
+    for (const Mesh& mesh : meshes) {
+        float distance = glm::length(localViewPos - glm::clamp(localViewPos, mesh.boundsMin, mesh.boundsMax));
+        for (const Texture& texture : mesh.textures) {
+            float priority = distance;
+            if (feedback && feedback->getDesiredMip(texture.id) == TextureFeedback::NOT_SAMPLED)
+                priority += UNSEEN_PENALTY;
+            auto it = priorities.find(texture.id);
+            if (it == priorities.end()) priorities.emplace(texture.id, priority);
+            else it->second = std::min(it->second, priority);
+        }
+    }
+    for (const auto& [texture, priority] : priorities)
+        uploads->setPriority(texture, priority);
 }
 
 void Model::loadModel(const std::string const& path) {
+    this->path = path;
+    std::vector<MeshData> data;
+    if (!importScene(path, data)) return;
+
+    for (MeshData& mesh : data) {
+        meshHashes.push_back(mesh.hash());
+        meshes.push_back(Mesh(std::move(mesh.vertices), std::move(mesh.indices), std::move(mesh.textures)));
+    }
+    assignMaterialIds();
+}
+
+bool Model::reload() {
+    // keep the current meshes if the new import fails
+    std::vector<MeshData> data;
+    if (!importScene(path, data)) return false;
+
+    bool changed = meshes.size() != data.size();
+    for (size_t i = 0; i < data.size(); i++) {
+        uint64_t hash = data[i].hash();
+        if (i < meshes.size() && meshHashes[i] == hash) continue;
+        changed = true;
+
+        Mesh mesh(std::move(data[i].vertices), std::move(data[i].indices), std::move(data[i].textures));
+        if (i < meshes.size()) {
+            meshes[i].release();
+            meshes[i] = mesh;
+            meshHashes[i] = hash;
+        }
+        else {
+            meshes.push_back(mesh);
+            meshHashes.push_back(hash);
+        }
+    }
+
+    // meshes that no longer exist in the file
+    for (size_t i = data.size(); i < meshes.size(); i++)
+        meshes[i].release();
+    if (meshes.size() > data.size()) {
+        meshes.erase(meshes.begin() + data.size(), meshes.end());
+        meshHashes.resize(data.size());
+    }
+    assignMaterialIds();
+    return changed;
+}
+
+Model::FileChange Model::onFileChanged(const std::string& changedPath) {
+    std::filesystem::path changed = std::filesystem::path(changedPath).lexically_normal();
+
+    // the source file or one of the material libraries next to it
+    if (changed == std::filesystem::path(path).lexically_normal() ||
+        (changed.extension() == ".mtl" && changed.parent_path() == std::filesystem::path(directory).lexically_normal())) {
+        return { reload(), 0 };
+    }
+
+    for (Texture& texture : textures_loaded) {
+        if (changed == (std::filesystem::path(directory) / texture.path).lexically_normal()) {
+            reloadTexture(texture);
+            return { false, texture.id };
+        }
+    }
+    return {};
+}
+
+void Model::releaseRetiredTextures() {
+    if (retiredTextures.empty()) return;
+    glDeleteTextures((GLsizei)retiredTextures.size(), retiredTextures.data());
+    retiredTextures.clear();
+    GLState::invalidate();
+}
+
+bool Model::importScene(const std::string& path, std::vector<MeshData>& out) {
+    directory = path.substr(0, path.find_last_of('/'));
+
+    // converted meshes are cached under the source contents and import settings
+    uint64_t key = 0;
+    uint64_t sourceHash;
+    if (cache && hashSource(path, sourceHash)) {
+        key = AssetCache::makeKey(sourceHash, IMPORT_FLAGS, "mesh");
+        std::vector<char> data;
+        if (cache->load(key, data)) {
+            if (deserializeMeshes(data, out, pool)) {
+                for (MeshData& mesh : out)
+                    for (Texture& texture : mesh.textures)
+                        texture = loadTexture(texture.path, texture.type);
+                return true;
+            }
+            fprintf(stderr, "Ignoring corrupt mesh cache entry for %s\n", path.c_str());
+            out.clear();
+        }
+    }
+
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path,
-        aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals |
-        aiProcess_FlipUVs | 
-        aiProcess_CalcTangentSpace);
+    const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         fprintf(stderr, "Assimp error:\n%s\n", importer.GetErrorString());
-        return;
+        return false;
     }
-    directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, out);
+
+    if (key) {
+        std::vector<char> data = serializeMeshes(out);
+        cache->store(key, data.data(), data.size());
+    }
+    return true;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& out) {
     // iterate meshes
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         // node object contains indexes to objects in scene, scene contains actual data
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        out.push_back(processMesh(mesh, scene));
     }
     
     // recursively process children
     for (unsigned int i = 0; i < node->mNumChildren; i++)
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, out);
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
+MeshData Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
     // iterate vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vertex;
+        Vertex vertex{}; // zeroed so unused fields hash deterministically
         glm::vec3 vector;
         // positions
         vector.x = mesh->mVertices[i].x;
@@ -107,7 +440,7 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-    return Mesh(vertices, indices, textures);
+    return MeshData{ std::move(vertices), std::move(indices), std::move(textures) };
 }
 
 std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName) {
@@ -115,56 +448,148 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break;
-            }
-        }
-        if (!skip) {
-            Texture texture;
-            texture.id = loadTextureFromFile(str.C_Str(), directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
-        }
+        textures.push_back(loadTexture(str.C_Str(), typeName));
     }
     return textures;
 }
 
-unsigned int loadTextureFromFile(const char* path, const std::string& directory) {
+Texture Model::loadTexture(const std::string& path, const std::string& typeName) {
+    for (unsigned int j = 0; j < textures_loaded.size(); j++) {
+        if (textures_loaded[j].path == path)
+            return textures_loaded[j];
+    }
+    Texture texture;
+    texture.id = loadTextureFromFile(path.c_str(), directory, uploads);
+    texture.type = typeName;
+    texture.path = path;
+    textures_loaded.push_back(texture);
+    return texture;
+}
+
+static void textureFormats(int components, GLenum& format, GLenum& internalFormat) {
+    if (components == 1) { format = GL_RED; internalFormat = GL_R8; }
+    else if (components == 2) { format = GL_RG; internalFormat = GL_RG8; }
+    else if (components == 3) { format = GL_RGB; internalFormat = GL_RGB8; }
+    else { format = GL_RGBA; internalFormat = GL_RGBA8; }
+}
+
+// upload level 0 right away and build mips, takes ownership of data
+static void uploadImage(unsigned int textureID, int width, int height, GLenum format, unsigned char* data) {
+    GLState::pixelStore(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(textureID, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+    GLState::pixelStore(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateTextureMipmap(textureID);
+    stbi_image_free(data);
+}
+
+unsigned int loadTextureFromFile(const char* path, const std::string& directory, UploadQueue* uploads) {
     std::string filename = std::string(path);
     filename = directory + '/' + filename;
 
     unsigned int textureID;
-    glGenTextures(1, &textureID);
+    glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
     stbi_set_flip_vertically_on_load(true);
 
     int width, height, nrComponents;
     unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data) {
-        GLenum format;
-        if (nrComponents == 1) format = GL_RED;
-        else if (nrComponents == 3) format = GL_RGB;
-        else if (nrComponents == 4) format = GL_RGBA;
+        GLenum format, internalFormat;
+        textureFormats(nrComponents, format, internalFormat);
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // immutable storage for the full mip chain so uploads can arrive in pieces
+        int levels = 1 + (int)std::floor(std::log2(std::max(width, height)));
+        glTextureStorage2D(textureID, levels, internalFormat, width, height);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        stbi_image_free(data);
+        if (uploads) {
+            // sample as black until the queue has streamed the image in
+            for (int level = 0; level < levels; level++)
+                glClearTexImage(textureID, level, format, GL_UNSIGNED_BYTE, nullptr);
+            uploads->enqueueTexture(textureID, width, height, nrComponents, data);
+        }
+        else {
+            uploadImage(textureID, width, height, format, data);
+        }
     }
     else {
+        // 0 leaves the material role unset, so it samples nothing rather than a texture without storage
         fprintf(stderr, "Error loading texture from: %s\n", filename.c_str());
+        glDeleteTextures(1, &textureID);
+        textureID = 0;
     }
 
     return textureID;
+}
+
+void Model::reloadTexture(Texture& texture) {
+    // a texture that failed to load before has no object yet, the meshes using it gain the role now
+    if (!texture.id) {
+        texture.id = loadTextureFromFile(texture.path.c_str(), directory, uploads);
+        if (!texture.id) return;
+        for (Mesh& mesh : meshes) {
+            for (Texture& meshTexture : mesh.textures) {
+                if (meshTexture.path != texture.path) continue;
+                meshTexture.id = texture.id;
+                TextureRole role;
+                if (Material::roleFromType(meshTexture.type, role)) mesh.material.setTexture(role, texture.id);
+            }
+            mesh.material.finalize();
+        }
+        assignMaterialIds();
+        return;
+    }
+
+    std::string filename = directory + '/' + texture.path;
+    stbi_set_flip_vertically_on_load(true);
+
+    int width, height, nrComponents;
+    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    if (!data) {
+        fprintf(stderr, "Error reloading texture from: %s\n", filename.c_str());
+        return;
+    }
+    if (uploads) uploads->cancel(texture.id);
+
+    GLenum format, internalFormat;
+    textureFormats(nrComponents, format, internalFormat);
+
+    // same size and format, overwrite the existing storage in place
+    int oldWidth = 0, oldHeight = 0, oldFormat = 0;
+    glGetTextureLevelParameteriv(texture.id, 0, GL_TEXTURE_WIDTH, &oldWidth);
+    glGetTextureLevelParameteriv(texture.id, 0, GL_TEXTURE_HEIGHT, &oldHeight);
+    glGetTextureLevelParameteriv(texture.id, 0, GL_TEXTURE_INTERNAL_FORMAT, &oldFormat);
+    if (oldWidth == width && oldHeight == height && (GLenum)oldFormat == internalFormat) {
+        if (uploads) uploads->enqueueTexture(texture.id, width, height, nrComponents, data);
+        else uploadImage(texture.id, width, height, format, data);
+        return;
+    }
+
+    // storage is immutable, so a resized texture gets a new object that every user is pointed at
+    stbi_image_free(data);
+    unsigned int oldID = texture.id;
+    unsigned int newID = loadTextureFromFile(texture.path.c_str(), directory, uploads);
+    for (Mesh& mesh : meshes) {
+        for (Texture& meshTexture : mesh.textures)
+            if (meshTexture.id == oldID) meshTexture.id = newID;
+        for (uint32_t& materialTexture : mesh.material.textures)
+            if (materialTexture == oldID) materialTexture = newID;
+        mesh.material.finalize();
+    }
+    assignMaterialIds();
+    texture.id = newID;
+    retiredTextures.push_back(oldID); // material tables may still hold a handle to it
+}
+
+void Model::assignMaterialIds() {
+    // every mesh of one assimp material resolves to the same textures, so this dedupes them
+    std::map<std::array<uint32_t, (size_t)TextureRole::Count>, uint32_t> ids;
+    for (Mesh& mesh : meshes) {
+        std::array<uint32_t, (size_t)TextureRole::Count> key;
+        std::copy(std::begin(mesh.material.textures), std::end(mesh.material.textures), key.begin());
+        mesh.material.id = ids.emplace(key, (uint32_t)ids.size() + 1).first->second;
+    }
 }
\ No newline at end of file
@@ -5,29 +5,87 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "RenderQueue.h"
+#include "AssetCache.h"
+#include "ThreadPool.h"
+#include "TextureFeedback.h"
+#include "UploadQueue.h"
+#include "RingBuffer.h"
+#include "SceneBuffer.h"
 
 #include <string>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <vector>
 #include <atomic>
+#include <unordered_map>
+#include <span>
 
-unsigned int loadTextureFromFile(const char* path, const std::string& directory);
+// uploads immediately when no queue is given, otherwise only allocates storage and defers the upload
+unsigned int loadTextureFromFile(const char* path, const std::string& directory, UploadQueue* uploads = nullptr);
 
 class Model {
 public:
+    static constexpr uint32_t INSTANCE_BINDING = 4; // instance transform ssbo used by model.vert
+
     std::vector<Texture> textures_loaded;
     std::vector<Mesh> meshes;
+    std::vector<uint64_t> meshHashes; // MeshData::hash of each mesh as last imported
+    std::string path;
     std::string directory;
     bool gammaCorrection = false;
 
-    Model(std::string const& path);
-    void Draw(ShaderProgram& shader);
+    // what onFileChanged touched, so tables built from the model only redo the affected parts
+    struct FileChange {
+        bool meshes = false; // meshes were replaced, added or removed
+        uint32_t texture = 0; // texture whose contents were reloaded, under its new name if replaced
+    };
+
+    Model(std::string const& path, UploadQueue* uploads = nullptr, AssetCache* cache = nullptr, ThreadPool* pool = nullptr);
+    // draws each mesh with the variant matching its material, meshes whose variant is still
+    // compiling are skipped
+    void Draw(ShaderVariants& shaders, const glm::mat4& transform);
+    // draws one copy per transform with a single instanced call per mesh. transforms are packed
+    // into the ring and read through gl_InstanceID, if visible is given it holds a culling result
+    // per transform and only the nonzero ones are packed. like Draw, the variants must be built
+    // without VERTEX_PULLING and, when they use a material table, the table must be bound
+    void DrawInstanced(ShaderVariants& shaders, std::span<const glm::mat4> transforms, RingBuffer& ring,
+        std::span<const uint8_t> visible = {});
+    // one scene object per mesh, replacing any added before (e.g. after a reload)
+    void addToScene(SceneBuffer& scene, const glm::mat4& transform);
+    void setTransform(SceneBuffer& scene, const glm::mat4& transform);
+    // queue each mesh whose variant is ready, depth is the distance from viewPos to its bounds.
+    // with a scene on the queue the meshes are submitted by their scene objects. packets are
+    // recorded in parallel on the model's pool, variants must already exist (prepareVariants)
+    void enqueue(RenderQueue& queue, ShaderVariants& shaders, const glm::mat4& transform, const glm::vec3& viewPos) const;
+    // submit the variants every mesh needs, so they compile together
+    void prepareVariants(ShaderVariants& shaders) const;
+    // re-import the source file and replace only the meshes whose contents changed, true if any did
+    bool reload();
+    // reacts to a changed file if it belongs to this model, an empty change otherwise
+    FileChange onFileChanged(const std::string& changedPath);
+    // delete textures that a reload replaced, once nothing built from the model refers to them
+    void releaseRetiredTextures();
+    // rank pending texture uploads by distance to the viewer, textures reported as sampled go first
+    void prioritizeUploads(const glm::vec3& viewPos, const glm::mat4& transform, const TextureFeedback* feedback = nullptr);
 
 private:
+    std::vector<uint32_t> objectIds; // scene object of each mesh
+    std::vector<uint32_t> retiredTextures;
+    UploadQueue* uploads = nullptr;
+    AssetCache* cache = nullptr;
+    ThreadPool* pool = nullptr;
+
     void loadModel(const std::string const& path);
-    void processNode(aiNode* node, const aiScene* scene);
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+    bool importScene(const std::string& path, std::vector<MeshData>& out);
+    void processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& out);
+    MeshData processMesh(aiMesh* mesh, const aiScene* scene);
+    void reloadTexture(Texture& texture);
+    // dense material ids from 1, shared by meshes with identical textures. recomputed whenever
+    // meshes or texture names change, so an id never outlives the textures it stands for
+    void assignMaterialIds();
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+    Texture loadTexture(const std::string& path, const std::string& typeName);
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "Profiler.h"
+
+#include <cstring>
+
+struct StatInfo {
+    const char* name;
+    bool isTime;
+};
+
+// indexed by Profiler::Stat
+static constexpr StatInfo STAT_INFO[] = {
+    { "Uniform Sets", false },
+    { "Uniforms Skipped", false },
+    { "Uniform Time", true },
+    { "Draw Calls", false },
+    { "Program Binds", false },
+    { "Material Binds", false },
+    { "State Calls Issued", false },
+    { "State Calls Elided", false },
+    { "Frame Wait Time", true },
+    { "GPU Frame Time", true },
+    { "Render Prep Time", true },
+};
+static_assert(sizeof(STAT_INFO) / sizeof(STAT_INFO[0]) == (size_t)Profiler::Stat::Count, "missing StatInfo entry");
+
+double Profiler::current[(size_t)Stat::Count] = {};
+double Profiler::last[(size_t)Stat::Count] = {};
+
+void Profiler::endFrame() {
+    std::memcpy(last, current, sizeof(current));
+    std::memset(current, 0, sizeof(current));
+}
+
+const char* Profiler::getName(Stat stat) {
+    return STAT_INFO[(size_t)stat].name;
+}
+
+bool Profiler::isTime(Stat stat) {
+    return STAT_INFO[(size_t)stat].isTime;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// per-frame counters and timings, accumulated during a frame and shown in the debug panel
+// NOTE: not thread safe, only record from the thread that owns the gl context
+class Profiler {
+public:
+    enum class Stat {
+        UniformSets,
+        UniformsSkipped,
+        UniformTime,
+        DrawCalls,
+        ProgramBinds,
+        MaterialBinds,
+        StateCallsIssued,
+        StateCallsElided,
+        FrameWaitTime,
+        GpuFrameTime,
+        PrepTime,
+        Count
+    };
+
+    static void count(Stat stat, uint64_t n = 1) { current[(size_t)stat] += (double)n; }
+    static void addTime(Stat stat, double ms) { current[(size_t)stat] += ms; }
+
+    // publish this frame's values and start the next frame from zero
+    static void endFrame();
+
+    // values of the last completed frame
+    static double get(Stat stat) { return last[(size_t)stat]; }
+    static const char* getName(Stat stat);
+    static bool isTime(Stat stat);
+
+    // adds the lifetime of the scope to a time stat
+    class ScopedTimer {
+    public:
+        ScopedTimer(Stat stat) : stat(stat), start(std::chrono::high_resolution_clock::now()) {}
+        ~ScopedTimer() {
+            addTime(stat, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+    private:
+        Stat stat;
+        std::chrono::high_resolution_clock::time_point start;
+    };
+
+private:
+    static double current[(size_t)Stat::Count];
+    static double last[(size_t)Stat::Count];
+};
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include "MaterialTable.h"
+#include "GLState.h"
+#include "RingBuffer.h"
+#include "SceneBuffer.h"
+#include "GpuCuller.h"
+
+#include <algorithm>
+
+static constexpr uint32_t VERTEX_ARRAY_BITS = 12;
+static constexpr uint32_t DEPTH_BITS = 24;
+static constexpr uint32_t MATERIAL_BITS = 14;
+static constexpr uint32_t PROGRAM_BITS = 12;
+static constexpr uint32_t PASS_BITS = 2;
+static_assert(VERTEX_ARRAY_BITS + DEPTH_BITS + MATERIAL_BITS + PROGRAM_BITS + PASS_BITS == 64);
+static_assert((uint32_t)RenderQueue::Pass::Count <= (1u << PASS_BITS));
+
+static uint64_t field(uint64_t value, uint32_t bits, uint32_t shift) {
+    return (value & ((1ull << bits) - 1)) << shift;
+}
+
+uint64_t RenderQueue::makeKey(Pass pass, uint32_t program, uint32_t material, uint32_t vertexArray, float depth01) {
+    constexpr uint32_t depthMax = (1u << DEPTH_BITS) - 1;
+    uint32_t depth = (uint32_t)(std::clamp(depth01, 0.0f, 1.0f) * depthMax);
+    if (pass == Pass::Transparent) depth = depthMax - depth;
+
+    uint32_t shift = 0;
+    uint64_t key = field(vertexArray, VERTEX_ARRAY_BITS, shift);
+    key |= field(depth, DEPTH_BITS, shift += VERTEX_ARRAY_BITS);
+    key |= field(material, MATERIAL_BITS, shift += DEPTH_BITS);
+    key |= field(program, PROGRAM_BITS, shift += MATERIAL_BITS);
+    key |= field((uint32_t)pass, PASS_BITS, shift += PROGRAM_BITS);
+    return key;
+}
+
+uint32_t RenderQueue::addTransform(const glm::mat4& transform) {
+    transforms.push_back(transform);
+    return (uint32_t)transforms.size() - 1;
+}
+
+RenderQueue::Packet RenderQueue::makePacket(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth) const {
+    // pulled meshes all draw from the pool's vertex array
+    uint32_t vertexArray = geometry ? 0 : mesh.VAO;
+    uint64_t key = makeKey(pass, program.id, mesh.material.id, vertexArray, depth / maxDepth);
+    return { key, &program, &mesh, transform };
+}
+
+void RenderQueue::submit(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth) {
+    packets.push_back(makePacket(pass, program, mesh, transform, depth));
+}
+
+void RenderQueue::Arena::submit(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth) {
+    packets.push_back(queue->makePacket(pass, program, mesh, transform, depth));
+}
+
+void RenderQueue::record(ThreadPool* pool, size_t count, const std::function<void(size_t, Arena&)>& fn, size_t chunkSize) {
+    Profiler::ScopedTimer timer(Profiler::Stat::PrepTime);
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (arenas.size() < chunkCount) arenas.resize(chunkCount);
+
+    auto recordChunk = [&](size_t chunk) {
+        Arena& arena = arenas[chunk];
+        arena.queue = this;
+        arena.packets.clear();
+        size_t end = std::min(count, (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; i++)
+            fn(i, arena);
+    };
+    if (pool && chunkCount > 1) pool->parallelFor(chunkCount, recordChunk);
+    else for (size_t chunk = 0; chunk < chunkCount; chunk++) recordChunk(chunk);
+
+    for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        packets.insert(packets.end(), arenas[chunk].packets.begin(), arenas[chunk].packets.end());
+}
+
+// lsd radix sort, 8 bits per pass, skipping passes where every key shares the digit
+void RenderQueue::sort() {
+    size_t count = packets.size();
+    scratch.resize(count);
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = {};
+        for (const Packet& packet : packets)
+            offsets[(packet.key >> shift) & 0xFF]++;
+        if (offsets[(packets.empty() ? 0 : packets[0].key >> shift) & 0xFF] == count) continue;
+
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            size_t n = offset;
+            offset = sum;
+            sum += n;
+        }
+        for (const Packet& packet : packets)
+            scratch[offsets[(packet.key >> shift) & 0xFF]++] = packet;
+        packets.swap(scratch);
+    }
+}
+
+void RenderQueue::execute() {
+    if (geometry && materials && ring) {
+        executeIndirect();
+        return;
+    }
+
+    const ShaderProgram* program = nullptr;
+    uint32_t material = 0;
+    uint32_t vertexArray = 0;
+    if (materials) materials->bind();
+
+    for (const Packet& packet : packets) {
+        const Mesh& mesh = *packet.mesh;
+        if (packet.program != program) {
+            program = packet.program;
+            GLState::useProgram(program->id);
+            program->setBool("instanced", false);
+            material = 0; // feedback ids are per program
+            Profiler::count(Profiler::Stat::ProgramBinds);
+        }
+        if (mesh.material.id != material) {
+            material = mesh.material.id;
+            if (materials) program->setInt("materialId", (int)material);
+            else mesh.material.bind();
+            const uint32_t* ids = mesh.material.textures;
+            program->setUVec4("feedbackTextureIds", glm::uvec4(ids[0], ids[1], ids[2], ids[3]));
+            Profiler::count(Profiler::Stat::MaterialBinds);
+        }
+        if (mesh.VAO != vertexArray) {
+            vertexArray = mesh.VAO;
+            GLState::bindVertexArray(vertexArray);
+        }
+        program->setMat4("model", scene ? scene->get(packet.transform).world : transforms[packet.transform]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0);
+        Profiler::count(Profiler::Stat::DrawCalls);
+    }
+}
+
+void RenderQueue::executeIndirect() {
+    draws.clear();
+    commands.clear();
+    batches.clear();
+    for (const Packet& packet : packets) {
+        const GeometryPool::Range* range = geometry->find(*packet.mesh);
+        if (!range) continue;
+        if (batches.empty() || batches.back().program != packet.program)
+            batches.push_back({ packet.program, (uint32_t)commands.size(), 0 });
+        batches.back().count++;
+
+        const Material& material = packet.mesh->material;
+        DrawData draw = {};
+        draw.objectId = packet.transform;
+        draw.feedbackTextureIds = glm::uvec4(material.textures[0], material.textures[1], material.textures[2], material.textures[3]);
+        draw.materialId = material.id;
+        draw.batch = (uint32_t)batches.size() - 1;
+        draw.batchFirst = batches.back().first;
+        draws.push_back(draw);
+        commands.push_back(geometry->commandFor(*range));
+    }
+    if (commands.empty()) return;
+
+    // without a scene the queue's transforms stand in for it for this frame
+    if (scene) scene->bind();
+    else {
+        objects.assign(transforms.size(), {});
+        for (size_t i = 0; i < transforms.size(); i++)
+            objects[i].world = transforms[i];
+        BufferRange objectData = stream(objects.data(), objects.size() * sizeof(ObjectData), ring->getStorageAlignment(), objectOverflow);
+        GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, SceneBuffer::BINDING, objectData.buffer, objectData.offset, objectData.size);
+    }
+
+    // the commands double as the culler's candidates, so they are aligned for binding as storage
+    BufferRange drawData = stream(draws.data(), draws.size() * sizeof(DrawData), ring->getStorageAlignment(), drawOverflow);
+    BufferRange commandData = stream(commands.data(), commands.size() * sizeof(DrawCommand), ring->getStorageAlignment(), commandOverflow);
+
+    // only scene objects carry bounds, so culling needs the scene. culled batches keep their
+    // ranges, the gpu writes how many draws of each survived
+    bool culled = culler && scene && culler->cull(commandData, drawData, (uint32_t)commands.size(), (uint32_t)batches.size());
+    size_t commandOffset = 0;
+    if (!culled) {
+        GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, DrawData::BINDING, drawData.buffer, drawData.offset, drawData.size);
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandData.buffer);
+        commandOffset = commandData.offset;
+    }
+    geometry->bind();
+    materials->bind();
+
+    // gl_DrawID restarts at every call, so each program is told where its draws begin
+    for (uint32_t i = 0; i < batches.size(); i++) {
+        const Batch& batch = batches[i];
+        GLState::useProgram(batch.program->id);
+        batch.program->setBool("instanced", false);
+        batch.program->setInt("drawBase", (int)batch.first);
+        if (culled) {
+            glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)GpuCuller::commandOffset(batch.first),
+                (GLintptr)GpuCuller::countOffset(i), (GLsizei)batch.count, 0);
+        }
+        else {
+            const void* offset = (const void*)(commandOffset + batch.first * sizeof(DrawCommand));
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, (GLsizei)batch.count, 0);
+        }
+        Profiler::count(Profiler::Stat::ProgramBinds);
+        Profiler::count(Profiler::Stat::DrawCalls);
+    }
+}
+
+BufferRange RenderQueue::stream(const void* data, size_t size, size_t alignment, Overflow& overflow) {
+    if (ring->fits(size, alignment)) {
+        RingBuffer::Allocation allocation = ring->write(data, size, alignment);
+        return { allocation.buffer, allocation.offset, allocation.size };
+    }
+
+    // the driver orders the update after any frame in flight that still reads the buffer
+    if (size > overflow.capacity) {
+        overflow.capacity = std::max(size, overflow.capacity * 2);
+        if (overflow.buffer) glDeleteBuffers(1, &overflow.buffer);
+        glCreateBuffers(1, &overflow.buffer);
+        glNamedBufferStorage(overflow.buffer, overflow.capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        GLState::invalidate();
+    }
+    glNamedBufferSubData(overflow.buffer, 0, size, data);
+    return { overflow.buffer, 0, size };
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    transforms.clear();
+}
+
+void RenderQueue::release() {
+    for (Overflow* overflow : { &objectOverflow, &drawOverflow, &commandOverflow }) {
+        if (overflow->buffer) glDeleteBuffers(1, &overflow->buffer);
+        *overflow = {};
+    }
+    GLState::invalidate();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "GeometryPool.h"
+#include "SceneBuffer.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class MaterialTable;
+class RingBuffer;
+class GpuCuller;
+
+// per-draw values of the vertex pulling path, std430 mirror of DrawData in scene.glsl
+struct DrawData {
+    static constexpr uint32_t BINDING = 3;
+
+    glm::uvec4 feedbackTextureIds;
+    uint32_t objectId; // into the scene buffer, or the frame's transforms without one
+    uint32_t materialId;
+    uint32_t batch; // program batch, for culling
+    uint32_t batchFirst; // first draw of the batch
+};
+static_assert(sizeof(DrawData) == 32);
+
+// a range of a gl buffer, for glBindBufferRange
+struct BufferRange {
+    uint32_t buffer = 0;
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// draws collected for a frame, sorted by a 64-bit key and submitted with redundant binds elided
+//
+// key layout, most significant first:
+//   pass 2 | program 12 | material 14 | depth 24 | vertex array 12
+// so state changes are minimised first and opaque draws within the same material go front to
+// back. vertex arrays come last since classic meshes each own one, they only break ties.
+// fields are truncated to their width, which can only cost sort quality since submission
+// compares the real objects
+class RenderQueue {
+public:
+    enum class Pass : uint32_t {
+        Opaque,
+        Transparent, // sorted back to front
+        Count
+    };
+
+    struct Packet {
+        uint64_t key;
+        ShaderProgram* program;
+        const Mesh* mesh;
+        uint32_t transform; // index into the queue's transforms, or a scene object id
+    };
+
+    float maxDepth = 1000.0f; // depth range quantised into the key, match the far plane
+    // when set, materials are selected by id from the table instead of binding their textures
+    const MaterialTable* materials = nullptr;
+    // when set together with materials and ring, draws fetch vertices from the pool and each
+    // program's packets go out as one multi-draw, programs must be built with VERTEX_PULLING
+    const GeometryPool* geometry = nullptr;
+    RingBuffer* ring = nullptr; // per-frame DrawData and indirect commands
+    // when set, packet transforms are object ids whose matrices live in the scene buffer
+    const SceneBuffer* scene = nullptr;
+    // when set together with a scene, the pulling path frustum culls its draws on the gpu
+    GpuCuller* culler = nullptr;
+
+    // packets recorded by one chunk of a parallel record(), so recording takes no locks
+    class Arena {
+    public:
+        void submit(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth);
+    private:
+        friend class RenderQueue;
+        const RenderQueue* queue = nullptr;
+        std::vector<Packet> packets;
+    };
+
+    // transforms are shared by every packet submitted with the returned index
+    uint32_t addTransform(const glm::mat4& transform);
+    void submit(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth);
+    // render prep: runs fn(i, arena) for every i in [0, count), split into chunks that the pool
+    // records in parallel, each into its own arena. arenas are appended in chunk order once all
+    // are done, so the packets do not depend on scheduling. fn must not make gl calls or add
+    // transforms. without a pool everything is recorded on the calling thread
+    void record(ThreadPool* pool, size_t count, const std::function<void(size_t, Arena&)>& fn, size_t chunkSize = 64);
+
+    void sort();
+    void execute();
+    void clear();
+    // delete the overflow buffers, call while the context is still current
+    void release();
+
+    size_t getCount() const { return packets.size(); }
+    static uint64_t makeKey(Pass pass, uint32_t program, uint32_t material, uint32_t vertexArray, float depth01);
+
+private:
+    std::vector<Packet> packets;
+    std::vector<Packet> scratch;
+    std::vector<Arena> arenas; // kept across frames so their storage is reused
+    std::vector<glm::mat4> transforms;
+
+    // consecutive draws of one program in the pulling path
+    struct Batch {
+        ShaderProgram* program;
+        uint32_t first, count;
+    };
+    std::vector<DrawData> draws;
+    std::vector<DrawCommand> commands;
+    std::vector<Batch> batches;
+    std::vector<ObjectData> objects;
+
+    // per-frame data that did not fit the ring region, kept in gpu storage grown to the largest
+    // frame seen so far
+    struct Overflow {
+        uint32_t buffer = 0;
+        size_t capacity = 0;
+    };
+    Overflow objectOverflow, drawOverflow, commandOverflow;
+
+    Packet makePacket(Pass pass, ShaderProgram& program, const Mesh& mesh, uint32_t transform, float depth) const;
+    void executeIndirect();
+    // upload through the ring when it has room, otherwise through the overflow buffer, so a
+    // frame is never dropped for being large
+    BufferRange stream(const void* data, size_t size, size_t alignment, Overflow& overflow);
+};
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "RenderThread.h"
+
+#include <chrono>
+
+RenderSnapshot::~RenderSnapshot() {
+    for (ImDrawList* list : imgui.CmdLists)
+        IM_DELETE(list);
+}
+
+void RenderSnapshot::copyImGui(const ImDrawData* data) {
+    for (ImDrawList* list : imgui.CmdLists)
+        IM_DELETE(list);
+    imgui = *data;
+    for (ImDrawList*& list : imgui.CmdLists)
+        list = list->CloneOutput();
+}
+
+RenderThread::RenderThread(GLFWwindow* window, RenderFn render) : window(window), render(std::move(render)) {
+    thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+    glfwMakeContextCurrent(window);
+}
+
+RenderSnapshot& RenderThread::beginSnapshot() {
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return !ready[writeSlot]; });
+    waitMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    return snapshots[writeSlot];
+}
+
+void RenderThread::publish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[writeSlot] = true;
+        writeSlot ^= 1;
+    }
+    changed.notify_all();
+}
+
+RenderStats RenderThread::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void RenderThread::run() {
+    glfwMakeContextCurrent(window);
+
+    uint32_t readSlot = 0;
+    RenderStats frameStats;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return ready[readSlot] || stopping; });
+            if (!ready[readSlot]) break; // stopping with nothing left to draw
+        }
+
+        // the slot is only written again once ready is cleared, so it is read without the lock
+        render(snapshots[readSlot], frameStats);
+        glfwSwapBuffers(window);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats = frameStats;
+            ready[readSlot] = false;
+        }
+        changed.notify_all();
+        readSlot ^= 1;
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <imgui.h>
+#include <glm/glm.hpp>
+
+#include "FrameConstants.h"
+#include "Profiler.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// everything the render thread needs for one frame, filled in by the main thread
+struct RenderSnapshot {
+    double time = 0.0, deltaTime = 0.0;
+    int framebufferWidth = 0, framebufferHeight = 0;
+    ViewConstants view = {};
+    glm::mat4 model = glm::mat4(1.0f);
+    bool drawWireframes = false;
+    bool gpuCulling = true;
+    bool feedbackEnabled = false;
+    uint32_t framesInFlight = 2;
+    uint32_t instancedCopies = 0;
+    ImDrawData imgui; // owns cloned draw lists
+
+    RenderSnapshot() = default;
+    RenderSnapshot(const RenderSnapshot&) = delete;
+    RenderSnapshot& operator=(const RenderSnapshot&) = delete;
+    ~RenderSnapshot();
+
+    // deep copies the draw lists, imgui reuses its own as soon as the next frame starts
+    void copyImGui(const ImDrawData* data);
+};
+
+// results of the last rendered frame for the debug panel
+struct RenderStats {
+    double profiler[(size_t)Profiler::Stat::Count] = {};
+    uint32_t sampledTextures = 0;
+    size_t shaderVariants = 0;
+    bool bindless = false;
+    size_t geometryBytes = 0;
+    size_t uploadDepth = 0, uploadBytes = 0;
+    double uploadMs = 0.0;
+    size_t ringUsed = 0, ringBytes = 0;
+    size_t sceneObjects = 0, sceneBytes = 0;
+};
+
+// owns the gl context on a dedicated thread. the main thread polls events, lays out imgui and
+// publishes one snapshot per frame, two snapshots are double buffered so the next frame can be
+// filled while the previous one renders
+// NOTE: the context must not be current on the creating thread, it is handed back on delete
+class RenderThread {
+public:
+    // called on the render thread once per published snapshot, buffers are swapped afterwards
+    using RenderFn = std::function<void(RenderSnapshot& snapshot, RenderStats& stats)>;
+
+    RenderThread(GLFWwindow* window, RenderFn render);
+    ~RenderThread();
+
+    // slot to fill for the next frame, blocks while the render thread still reads it
+    RenderSnapshot& beginSnapshot();
+    // hand the filled slot to the render thread
+    void publish();
+
+    RenderStats getStats() const;
+    double getWaitMs() const { return waitMs; } // time the last beginSnapshot blocked
+
+private:
+    GLFWwindow* window;
+    RenderFn render;
+    std::thread thread;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    RenderSnapshot snapshots[2];
+    bool ready[2] = {}; // published and not yet rendered
+    uint32_t writeSlot = 0;
+    bool stopping = false;
+    RenderStats stats;
+    double waitMs = 0.0;
+
+    void run();
+};
\ No newline at end of file
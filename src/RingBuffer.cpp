@@ -0,0 +1,52 @@
+#include "RingBuffer.h"
+
+#include <cstdio>
+#include <cstring>
+
+RingBuffer::RingBuffer(size_t frameBytes, const FrameSync& sync) : sync(sync), frameBytes(frameBytes) {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) uniformAlignment = (size_t)alignment;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) storageAlignment = (size_t)alignment;
+
+    // coherent, so writes are visible to the gpu without explicit flushes
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, frameBytes * FRAMES, nullptr, flags);
+    mapped = (unsigned char*)glMapNamedBufferRange(buffer, 0, frameBytes * FRAMES, flags);
+}
+
+RingBuffer::~RingBuffer() {
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+void RingBuffer::beginFrame() {
+    region = sync.getSlot();
+    head = 0;
+    reportedFull = false;
+}
+
+void RingBuffer::endFrame() {
+    usedLastFrame = head;
+}
+
+RingBuffer::Allocation RingBuffer::allocate(size_t size, size_t alignment) {
+    size_t offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + size > frameBytes) {
+        if (!reportedFull) fprintf(stderr, "Ring buffer region full (%zu bytes), dropping %zu byte allocation\n", frameBytes, size);
+        reportedFull = true;
+        return {};
+    }
+    head = offset + size;
+
+    size_t start = region * frameBytes + offset;
+    return { mapped + start, buffer, start, size };
+}
+
+RingBuffer::Allocation RingBuffer::write(const void* data, size_t size, size_t alignment) {
+    Allocation allocation = allocate(size, alignment);
+    if (allocation.data) std::memcpy(allocation.data, data, size);
+    return allocation;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "FrameSync.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// a persistently mapped, coherent buffer split into one region per frame in flight. per-frame
+// data is bump allocated straight into gpu visible memory with no driver copy. regions are
+// indexed by the FrameSync slot, which is only handed out again once its frame has finished
+// NOTE: not thread safe, only call from the thread that owns the gl context
+class RingBuffer {
+public:
+    static constexpr uint32_t FRAMES = FrameSync::MAX_FRAMES_IN_FLIGHT;
+
+    struct Allocation {
+        void* data = nullptr; // nullptr if the region is full
+        uint32_t buffer = 0;
+        size_t offset = 0; // from the start of the buffer, for glBindBufferRange
+        size_t size = 0;
+    };
+
+    RingBuffer(size_t frameBytes, const FrameSync& sync);
+    ~RingBuffer();
+
+    // starts writing the region of the current frame slot, call after FrameSync::beginFrame
+    void beginFrame();
+    void endFrame();
+
+    Allocation allocate(size_t size, size_t alignment);
+    // whether an allocation would succeed, for callers with somewhere else to put large data
+    bool fits(size_t size, size_t alignment) const { return (head + alignment - 1) / alignment * alignment + size <= frameBytes; }
+    Allocation write(const void* data, size_t size, size_t alignment);
+    // aligned for binding as a storage block, for callers that fill the memory themselves
+    Allocation allocateStorage(size_t size) { return allocate(size, storageAlignment); }
+    // aligned for binding as a uniform block
+    template <typename T>
+    Allocation writeUniform(const T& value) { return write(&value, sizeof(T), uniformAlignment); }
+    // aligned for binding as a storage block
+    Allocation writeStorage(const void* data, size_t size) { return write(data, size, storageAlignment); }
+
+    uint32_t getBuffer() const { return buffer; }
+    size_t getFrameBytes() const { return frameBytes; }
+    size_t getStorageAlignment() const { return storageAlignment; }
+    size_t getUsedLastFrame() const { return usedLastFrame; }
+
+private:
+    uint32_t buffer = 0;
+    unsigned char* mapped = nullptr;
+    const FrameSync& sync;
+    size_t frameBytes;
+    size_t uniformAlignment = 256, storageAlignment = 256;
+
+    uint32_t region = 0;
+    size_t head = 0; // bytes used in the current region
+    size_t usedLastFrame = 0;
+    bool reportedFull = false;
+};
\ No newline at end of file
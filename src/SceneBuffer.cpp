@@ -0,0 +1,87 @@
+#include "SceneBuffer.h"
+#include "GLState.h"
+
+#include <algorithm>
+
+SceneBuffer::~SceneBuffer() {
+    if (buffer) glDeleteBuffers(1, &buffer);
+}
+
+uint32_t SceneBuffer::add(const ObjectData& object) {
+    uint32_t id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+        objects[id] = object;
+    }
+    else {
+        id = (uint32_t)objects.size();
+        objects.push_back(object);
+        dirty.push_back(0);
+    }
+    markDirty(id);
+    return id;
+}
+
+void SceneBuffer::remove(uint32_t id) {
+    // zero scale collapses the slot until it is reused
+    objects[id] = {};
+    markDirty(id);
+    freeIds.push_back(id);
+}
+
+void SceneBuffer::setTransform(uint32_t id, const glm::mat4& world) {
+    if (objects[id].world == world) return;
+    objects[id].world = world;
+    markDirty(id);
+}
+
+void SceneBuffer::upload() {
+    bytesLastFrame = 0;
+    if (dirtyIds.empty()) return;
+    if (objects.size() > capacity) grow();
+
+    // coalesce neighbouring ids so each contiguous run is one copy
+    std::sort(dirtyIds.begin(), dirtyIds.end());
+    for (size_t i = 0; i < dirtyIds.size();) {
+        size_t end = i + 1;
+        while (end < dirtyIds.size() && dirtyIds[end] == dirtyIds[end - 1] + 1) end++;
+
+        uint32_t first = dirtyIds[i];
+        size_t size = (end - i) * sizeof(ObjectData);
+        if (ring.fits(size, sizeof(float) * 4)) {
+            RingBuffer::Allocation staging = ring.write(&objects[first], size, sizeof(float) * 4);
+            glCopyNamedBufferSubData(staging.buffer, buffer, staging.offset, first * sizeof(ObjectData), size);
+        }
+        // runs the region cannot hold, e.g. the first frame of a large scene, go through the driver
+        else glNamedBufferSubData(buffer, first * sizeof(ObjectData), size, &objects[first]);
+        bytesLastFrame += size;
+
+        for (size_t j = i; j < end; j++) dirty[dirtyIds[j]] = 0;
+        i = end;
+    }
+    dirtyIds.clear();
+}
+
+void SceneBuffer::bind() const {
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffer);
+}
+
+void SceneBuffer::markDirty(uint32_t id) {
+    if (dirty[id]) return;
+    dirty[id] = 1;
+    dirtyIds.push_back(id);
+}
+
+void SceneBuffer::grow() {
+    // storage is immutable, so a bigger buffer is made and every object uploaded into it again
+    capacity = std::max<size_t>(objects.size(), capacity * 2);
+    capacity = std::max<size_t>(capacity, 64);
+    if (buffer) glDeleteBuffers(1, &buffer);
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, capacity * sizeof(ObjectData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    GLState::invalidate();
+
+    for (uint32_t id = 0; id < objects.size(); id++)
+        markDirty(id);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "RingBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// std430 mirror of ObjectData in model.vert
+struct ObjectData {
+    glm::mat4 world;
+    glm::vec3 boundsMin; // object-space aabb
+    uint32_t materialId;
+    glm::vec3 boundsMax;
+    uint32_t pad;
+};
+static_assert(sizeof(ObjectData) == 96);
+
+// gpu resident copy of every object's world matrix, bounds and material, indexed by object id.
+// changes are tracked per object and only dirty ranges are uploaded (staged through the ring),
+// so an object that does not move costs nothing after its first frame
+// NOTE: not thread safe, only call from the thread that owns the gl context
+class SceneBuffer {
+public:
+    static constexpr uint32_t BINDING = 5; // ssbo binding point used by model.vert
+    static constexpr uint32_t INVALID = 0xFFFFFFFF;
+
+    SceneBuffer(RingBuffer& ring) : ring(ring) {}
+    ~SceneBuffer();
+
+    // ids of removed objects are reused
+    uint32_t add(const ObjectData& object);
+    void remove(uint32_t id);
+    // only marks the object dirty if the matrix actually changed
+    void setTransform(uint32_t id, const glm::mat4& world);
+
+    // copy dirty ranges to the gpu, call between RingBuffer::beginFrame and endFrame
+    void upload();
+    void bind() const;
+
+    const ObjectData& get(uint32_t id) const { return objects[id]; }
+    size_t getCount() const { return objects.size(); }
+    size_t getBytesLastFrame() const { return bytesLastFrame; }
+
+private:
+    RingBuffer& ring;
+    uint32_t buffer = 0;
+    size_t capacity = 0; // objects
+    std::vector<ObjectData> objects;
+    std::vector<uint8_t> dirty; // per object
+    std::vector<uint32_t> dirtyIds;
+    std::vector<uint32_t> freeIds;
+    size_t bytesLastFrame = 0;
+
+    void markDirty(uint32_t id);
+    void grow();
+};
\ No newline at end of file
@@ -1,33 +1,313 @@
 #include "Shader.h"
+#include "Profiler.h"
+#include "Spirv.h"
+#include "GLState.h"
 
-ShaderProgram::ShaderProgram(const char* vertPath, const char* fragPath) {
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
 
-	// retrieve source code from files
+// program binaries are only valid for the driver that produced them
+static uint64_t driverHash() {
+	static const uint64_t hash = [] {
+		uint64_t h = FNV_OFFSET_BASIS;
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const char* str = (const char*)glGetString(name);
+			h = fnv1a(str ? str : "", h);
+			h = fnv1a("\n", h);
+		}
+		return h;
+	}();
+	return hash;
+}
+
+ShaderProgram::ShaderProgram(const char* vertPath, const char* fragPath, const AssetCache* cache, std::vector<std::string> defines)
+	: vertPath(vertPath), fragPath(fragPath), cache(cache), defines(std::move(defines)) {
+	build();
+}
+
+ShaderProgram::ShaderProgram(const char* computePath, const AssetCache* cache, std::vector<std::string> defines)
+	: computePath(computePath), cache(cache), defines(std::move(defines)) {
+	build();
+}
+
+void ShaderProgram::use() {
+	GLState::useProgram(id);
+}
+
+void ShaderProgram::reload() {
+	cancel();
+	build();
+}
+
+bool ShaderProgram::usesFile(const std::string& path) const {
+	if (path == vertPath || path == fragPath || path == computePath) return true;
+	return std::find(files.begin(), files.end(), path) != files.end();
+}
+
+bool ShaderProgram::poll() {
+	if (!pending.program) return false;
+	if (GLExtensions::parallelShaderCompile) {
+		GLint done = GL_FALSE;
+		glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+		if (!done) return false;
+	}
+	return finish();
+}
+
+bool ShaderProgram::wait() {
+	if (!pending.program) return false;
+	return finish();
+}
+
+// status queries block until the driver is done, so only run once it reports completion
+bool ShaderProgram::finish() {
+	PendingBuild build = pending;
+	pending = {};
+
+	bool ok = true;
+	if (build.vert) {
+		ok = checkErrors(build.vert, computePath.empty() ? "VERTEX" : "COMPUTE");
+		if (build.frag) ok = checkErrors(build.frag, "FRAGMENT") && ok;
+		ok = checkErrors(build.program, "PROGRAM") && ok;
+		glDeleteShader(build.vert);
+		glDeleteShader(build.frag);
+		if (ok && cache) storeBinary(build.key, build.program);
+	}
+	if (!ok) {
+		glDeleteProgram(build.program);
+		if (id) fprintf(stderr, "Keeping previous program for %s\n", describe().c_str());
+		return false;
+	}
+
+	uint32_t previous = id;
+	std::unordered_map<int32_t, std::string> previousNames = std::move(spirvNames);
+	id = build.program;
+	spirvNames = std::move(build.spirvNames);
+	if (!reflect()) {
+		// colliding uniform names would alias each other's writes, so the program is rejected
+		glDeleteProgram(id);
+		if (cache && build.key) cache->remove(build.key);
+		id = previous;
+		spirvNames = std::move(previousNames);
+		reflect();
+		if (id) fprintf(stderr, "Keeping previous program for %s\n", describe().c_str());
+		return false;
+	}
+	if (previous) glDeleteProgram(previous);
+	return true;
+}
+
+void ShaderProgram::cancel() {
+	if (!pending.program) return;
+	if (pending.vert) {
+		glDeleteShader(pending.vert);
+		glDeleteShader(pending.frag);
+	}
+	glDeleteProgram(pending.program);
+	pending = {};
+}
+
+// expands #include "file" lines (GL_GOOGLE_include_directive syntax), resolved relative to the including file and each file included
+// once per stage, and inserts the defines after #version. #line directives keep compiler errors
+// pointing at the right line, with the source number being the file's index in included
+static bool preprocess(const std::string& path, const std::vector<std::string>& defines,
+	std::vector<std::string>& included, std::string& out) {
+	std::ifstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error reading shader file %s\n", path.c_str());
+		return false;
+	}
+	int fileIndex = (int)included.size();
+	included.push_back(path);
+	if (fileIndex > 0) out += "#line 1 " + std::to_string(fileIndex) + "\n";
+
+	bool ok = true;
+	int lineNumber = 0;
+	std::string line;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		size_t start = line.find_first_not_of(" \t");
+		std::string_view directive = start == std::string::npos ? std::string_view() : std::string_view(line).substr(start);
+
+		// only needed by glslangValidator, drivers do not know it
+		if (directive.starts_with("#extension GL_GOOGLE_include_directive")) {
+			out += '\n';
+			continue;
+		}
+		if (directive.starts_with("#include")) {
+			size_t open = line.find('"'), close = line.rfind('"');
+			if (open == std::string::npos || close <= open) {
+				fprintf(stderr, "Malformed #include in %s(%d)\n", path.c_str(), lineNumber);
+				ok = false;
+				continue;
+			}
+			std::filesystem::path target = std::filesystem::path(path).parent_path() / line.substr(open + 1, close - open - 1);
+			std::string includePath = target.lexically_normal().generic_string();
+			if (std::find(included.begin(), included.end(), includePath) == included.end())
+				ok = preprocess(includePath, defines, included, out) && ok;
+			out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+			continue;
+		}
+
+		out += line;
+		out += '\n';
+		if (directive.starts_with("#version") && !defines.empty()) {
+			for (const std::string& define : defines)
+				out += "#define " + define + "\n";
+			out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+		}
+	}
+	return ok;
+}
+
+void ShaderProgram::build() {
+	if (!computePath.empty()) {
+		buildCompute();
+		return;
+	}
+
+	// precompiled spir-v next to the glsl takes precedence, see buildSpirv
+	if (buildSpirv()) return;
+
+	// retrieve source code from files, expanding includes and defines
 
 	std::string vertSrc, fragSrc;
-	std::ifstream vertFile, fragFile;
-
-	vertFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fragFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try {
-		// open files
-		vertFile.open(vertPath);
-		fragFile.open(fragPath);
-		std::stringstream vertStream, fragStream;
-		// read file contents into streams
-		vertStream << vertFile.rdbuf();
-		fragStream << fragFile.rdbuf();
-		// close file handlers
-		vertFile.close();
-		fragFile.close();
-		// convert stream to string
-		vertSrc = vertStream.str();
-		fragSrc = fragStream.str();
-	}
-	catch (std::ifstream::failure e) {
-		fprintf(stderr, "Error reading shader file\n");
+	std::vector<std::string> vertFiles, fragFiles;
+	preprocess(vertPath, defines, vertFiles, vertSrc);
+	preprocess(fragPath, defines, fragFiles, fragSrc);
+	files = vertFiles;
+	files.insert(files.end(), fragFiles.begin(), fragFiles.end());
+
+	// reuse a cached binary when the sources and driver are unchanged
+	uint64_t key = 0;
+	if (cache) {
+		uint64_t sourceHash = fnv1a(vertSrc);
+		sourceHash = fnv1a(std::string_view("\0", 1), sourceHash);
+		sourceHash = fnv1a(fragSrc, sourceHash);
+		key = AssetCache::makeKey(sourceHash, driverHash(), "program");
+		if (uint32_t program = loadBinary(key)) {
+			pending.program = program;
+			return;
+		}
 	}
 
+	compile(vertSrc, fragSrc, key);
+}
+
+// same as the glsl path of build() for a single compute stage
+void ShaderProgram::buildCompute() {
+	std::string src;
+	files.clear();
+	preprocess(computePath, defines, files, src);
+
+	uint64_t key = 0;
+	if (cache) {
+		key = AssetCache::makeKey(fnv1a(src), driverHash(), "program");
+		if (uint32_t program = loadBinary(key)) {
+			pending.program = program;
+			return;
+		}
+	}
+
+	const char* code = src.c_str();
+	uint32_t shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &code, nullptr);
+	glCompileShader(shader);
+	uint32_t program = glCreateProgram();
+	if (cache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+
+	pending = { program, shader, 0, key, {} };
+}
+
+// loads shaders/x.vert.spv and shaders/x.frag.spv if both exist, built from the glsl with e.g.
+//   glslangValidator -G -o shaders/model.vert.spv shaders/model.vert
+// defines ("NAME value") set the specialization constant of the same name instead of being
+// inserted into source, false if the modules are missing, have no constant for a define or
+// fail to specialize
+// NOTE: the material table and vertex pulling defines change shader interfaces, which no
+// constant can, so every variant the app builds with them uses glsl and spir-v is effectively
+// retired for model.vert/model.frag
+bool ShaderProgram::buildSpirv() {
+	SpirvModule vertModule, fragModule;
+	if (!loadSpirv(vertPath + ".spv", vertModule) || !loadSpirv(fragPath + ".spv", fragModule)) return false;
+
+	// a define the modules have no constant for changes the source itself, which needs glsl
+	for (const std::string& define : defines) {
+		std::string name = define.substr(0, define.find(' '));
+		if (!vertModule.specIds.count(name) && !fragModule.specIds.count(name)) {
+			fprintf(stderr, "Ignoring spir-v for %s, no specialization constant for %s\n", describe().c_str(), name.c_str());
+			return false;
+		}
+	}
+	files = { vertPath + ".spv", fragPath + ".spv" };
+
+	uint64_t key = 0;
+	if (cache) {
+		uint64_t sourceHash = fnv1a(vertModule.words.data(), vertModule.words.size() * 4);
+		sourceHash = fnv1a(fragModule.words.data(), fragModule.words.size() * 4, sourceHash);
+		for (const std::string& define : defines)
+			sourceHash = fnv1a(define + "\n", sourceHash);
+		key = AssetCache::makeKey(sourceHash, driverHash(), "program");
+	}
+
+	// uniform names only exist in the modules, keep them for reflect()
+	std::unordered_map<int32_t, std::string> names = vertModule.uniformNames;
+	names.insert(fragModule.uniformNames.begin(), fragModule.uniformNames.end());
+
+	if (cache) {
+		if (uint32_t program = loadBinary(key)) {
+			pending.program = program;
+			pending.spirvNames = std::move(names);
+			return true;
+		}
+	}
+
+	uint32_t vert = specialize(GL_VERTEX_SHADER, vertModule);
+	uint32_t frag = vert ? specialize(GL_FRAGMENT_SHADER, fragModule) : 0;
+	if (!frag) {
+		if (vert) glDeleteShader(vert);
+		fprintf(stderr, "Falling back to glsl for %s, %s\n", vertPath.c_str(), fragPath.c_str());
+		return false;
+	}
+
+	uint32_t program = glCreateProgram();
+	if (cache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, vert);
+	glAttachShader(program, frag);
+	glLinkProgram(program);
+
+	pending = { program, vert, frag, key, std::move(names) };
+	return true;
+}
+
+// specialization skips the glsl front end entirely, so its status is cheap to check right away
+uint32_t ShaderProgram::specialize(GLenum stage, const SpirvModule& module) {
+	std::vector<GLuint> ids, values;
+	for (const std::string& define : defines) {
+		size_t space = define.find(' ');
+		auto it = module.specIds.find(define.substr(0, space));
+		if (it == module.specIds.end()) continue;
+		std::string value = space == std::string::npos ? "1" : define.substr(space + 1);
+		ids.push_back(it->second);
+		values.push_back(value == "true" ? 1 : value == "false" ? 0 : (GLuint)std::strtoul(value.c_str(), nullptr, 0));
+	}
+
+	uint32_t shader = glCreateShader(stage);
+	glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, module.words.data(), (GLsizei)(module.words.size() * 4));
+	glSpecializeShader(shader, "main", (GLuint)ids.size(), ids.data(), values.data());
+	if (!checkErrors(shader, stage == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT")) {
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+// submits compiles and the link without querying their status
+void ShaderProgram::compile(const std::string& vertSrc, const std::string& fragSrc, uint64_t key) {
 	const char* vertCode = vertSrc.c_str();
 	const char* fragCode = fragSrc.c_str();
 
@@ -37,29 +317,72 @@ ShaderProgram::ShaderProgram(const char* vertPath, const char* fragPath) {
 	uint32_t vert = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vert, 1, &vertCode, nullptr);
 	glCompileShader(vert);
-	checkErrors(vert, "VERTEX");
 	// frag shader
 	uint32_t frag = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(frag, 1, &fragCode, nullptr);
 	glCompileShader(frag);
-	checkErrors(frag, "FRAGMENT");
 	// shader program
-	id = glCreateProgram();
-	glAttachShader(id, vert);
-	glAttachShader(id, frag);
-	glLinkProgram(id);
-	checkErrors(id, "PROGRAM");
+	uint32_t program = glCreateProgram();
+	if (cache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, vert);
+	glAttachShader(program, frag);
+	glLinkProgram(program);
 
-	// cleanup
-	glDeleteShader(vert);
-	glDeleteShader(frag);
+	pending = { program, vert, frag, key, {} };
 }
 
-void ShaderProgram::use() {
-	glUseProgram(id);
+// cached entry: magic, binary format, binary
+uint32_t ShaderProgram::loadBinary(uint64_t key) {
+	std::vector<char> data;
+	if (!cache->load(key, data)) return 0;
+
+	uint32_t magic;
+	GLenum format;
+	constexpr size_t headerSize = sizeof(magic) + sizeof(format);
+	if (data.size() <= headerSize) {
+		cache->remove(key);
+		return 0;
+	}
+	std::memcpy(&magic, data.data(), sizeof(magic));
+	std::memcpy(&format, data.data() + sizeof(magic), sizeof(format));
+	if (magic != BINARY_CACHE_MAGIC) {
+		cache->remove(key);
+		return 0;
+	}
+
+	// drivers may reject binaries after an update even with identical version strings, the
+	// entry is removed so the caller's recompile can store a fresh one in its place
+	uint32_t program = glCreateProgram();
+	glProgramBinary(program, format, data.data() + headerSize, (GLsizei)(data.size() - headerSize));
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		fprintf(stderr, "Cached program binary rejected for %s, recompiling\n", describe().c_str());
+		glDeleteProgram(program);
+		cache->remove(key);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderProgram::storeBinary(uint64_t key, uint32_t program) {
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (numFormats == 0 || length == 0) return; // driver does not support binaries
+
+	uint32_t magic = BINARY_CACHE_MAGIC;
+	GLenum format = 0;
+	constexpr size_t headerSize = sizeof(magic) + sizeof(format);
+	std::vector<char> data(headerSize + length);
+	glGetProgramBinary(program, length, &length, &format, data.data() + headerSize);
+	std::memcpy(data.data(), &magic, sizeof(magic));
+	std::memcpy(data.data() + sizeof(magic), &format, sizeof(format));
+	cache->store(key, data.data(), headerSize + length);
 }
 
-void ShaderProgram::checkErrors(uint32_t id, std::string type) {
+bool ShaderProgram::checkErrors(uint32_t id, std::string type) {
 	int success;
 	char infoLog[512];
 	if (type != "PROGRAM") {
@@ -76,54 +399,241 @@ void ShaderProgram::checkErrors(uint32_t id, std::string type) {
 			fprintf(stderr, "Error linking %s program\n%s\n", type.c_str(), infoLog);
 		}
 	}
+	return success;
+}
+
+std::string ShaderProgram::describe() const {
+	return computePath.empty() ? vertPath + ", " + fragPath : computePath;
 }
 
+// gl type a setter of T uploads
+template <typename T> constexpr GLenum uniformType();
+template <> constexpr GLenum uniformType<bool>() { return GL_BOOL; }
+template <> constexpr GLenum uniformType<int>() { return GL_INT; }
+template <> constexpr GLenum uniformType<float>() { return GL_FLOAT; }
+template <> constexpr GLenum uniformType<glm::vec2>() { return GL_FLOAT_VEC2; }
+template <> constexpr GLenum uniformType<glm::vec3>() { return GL_FLOAT_VEC3; }
+template <> constexpr GLenum uniformType<glm::vec4>() { return GL_FLOAT_VEC4; }
+template <> constexpr GLenum uniformType<glm::uvec4>() { return GL_UNSIGNED_INT_VEC4; }
+template <> constexpr GLenum uniformType<glm::mat2>() { return GL_FLOAT_MAT2; }
+template <> constexpr GLenum uniformType<glm::mat3>() { return GL_FLOAT_MAT3; }
+template <> constexpr GLenum uniformType<glm::mat4>() { return GL_FLOAT_MAT4; }
+
+static bool isSamplerType(GLenum type) {
+	switch (type) {
+	case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY:
+	case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void uploadUniform(uint32_t program, int32_t location, bool value) { glProgramUniform1i(program, location, (int)value); }
+static void uploadUniform(uint32_t program, int32_t location, int value) { glProgramUniform1i(program, location, value); }
+static void uploadUniform(uint32_t program, int32_t location, float value) { glProgramUniform1f(program, location, value); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::vec2& value) { glProgramUniform2fv(program, location, 1, &value[0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::vec3& value) { glProgramUniform3fv(program, location, 1, &value[0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::vec4& value) { glProgramUniform4fv(program, location, 1, &value[0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::uvec4& value) { glProgramUniform4uiv(program, location, 1, &value[0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::mat2& mat) { glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, &mat[0][0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::mat3& mat) { glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, &mat[0][0]); }
+static void uploadUniform(uint32_t program, int32_t location, const glm::mat4& mat) { glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, &mat[0][0]); }
+
+bool ShaderProgram::reflect() {
+	static uint32_t nextGeneration = 1;
+	generation = nextGeneration++;
+
+	uniforms.clear();
+	blocks.clear();
+	values.clear();
+	if (!id) return true;
+
+	// default-block uniforms, block members are skipped as they have no location
+	GLint count = 0;
+	glGetProgramInterfaceiv(id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	const GLenum uniformProps[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+	for (GLint i = 0; i < count; i++) {
+		GLint props[5];
+		glGetProgramResourceiv(id, GL_UNIFORM, i, 5, uniformProps, 5, nullptr, props);
+		if (props[4] != -1 || props[2] < 0) continue;
+
+		std::string name;
+		if (props[0] > 1) {
+			name.resize(props[0]);
+			glGetProgramResourceName(id, GL_UNIFORM, i, props[0], nullptr, name.data());
+			name.resize(props[0] - 1);
+		}
+		else {
+			// spir-v programs report no names, use the ones read from the module
+			auto it = spirvNames.find(props[2]);
+			if (it == spirvNames.end()) continue;
+			name = it->second;
+		}
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) name.resize(name.size() - 3);
+		uniforms.push_back({ name, fnv1a(name), props[2], (GLenum)props[1], props[3], false });
+	}
+	std::sort(uniforms.begin(), uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.hash < b.hash; });
+	for (size_t i = 1; i < uniforms.size(); i++) {
+		if (uniforms[i].hash == uniforms[i - 1].hash) {
+			fprintf(stderr, "Uniform name hash collision in %s: %s, %s\n", describe().c_str(), uniforms[i - 1].name.c_str(), uniforms[i].name.c_str());
+			uniforms.clear();
+			return false;
+		}
+	}
+	values.assign(uniforms.size() * MAX_UNIFORM_SIZE, 0);
+
+	// uniform and shader storage blocks
+	const GLenum blockProps[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	for (GLenum blockInterface : { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK }) {
+		glGetProgramInterfaceiv(id, blockInterface, GL_ACTIVE_RESOURCES, &count);
+		for (GLint i = 0; i < count; i++) {
+			GLint props[3];
+			glGetProgramResourceiv(id, blockInterface, i, 3, blockProps, 3, nullptr, props);
+			std::string name;
+			if (props[0] > 1) {
+				name.resize(props[0]);
+				glGetProgramResourceName(id, blockInterface, i, props[0], nullptr, name.data());
+				name.resize(props[0] - 1);
+			}
+			blocks.push_back({ name, blockInterface == GL_SHADER_STORAGE_BLOCK, props[1], props[2] });
+		}
+	}
+	return true;
+}
+
+int32_t ShaderProgram::findUniformIndex(UniformName name) const {
+	auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name.hash,
+		[](const Uniform& uniform, uint64_t hash) { return uniform.hash < hash; });
+	if (it == uniforms.end() || it->hash != name.hash) return -1; // inactive or optimised out
+#ifdef _DEBUG
+	// reflection rejects collisions between active uniforms, this catches a name the program
+	// does not have hashing like one it does
+	if (it->name != name.name) {
+		fprintf(stderr, "Uniform %.*s collides with %s\n", (int)name.name.size(), name.name.data(), it->name.c_str());
+		return -1;
+	}
+#endif
+	return (int32_t)(it - uniforms.begin());
+}
+
+const ShaderProgram::Uniform* ShaderProgram::findUniform(UniformName name) const {
+	int32_t index = findUniformIndex(name);
+	return index < 0 ? nullptr : &uniforms[index];
+}
+
+const ShaderProgram::Block* ShaderProgram::findBlock(const std::string& name) const {
+	for (const Block& block : blocks)
+		if (block.name == name) return &block;
+	return nullptr;
+}
+
+// uploads unless the value matches the one last uploaded, through glProgramUniform so the
+// cache stays correct whichever program is bound
+template <typename T>
+void ShaderProgram::setValue(int32_t index, const T& value) const {
+	if (index < 0) return;
+
+	Profiler::ScopedTimer timer(Profiler::Stat::UniformTime);
+	const Uniform& uniform = uniforms[index];
+	uint8_t* cached = values.data() + index * MAX_UNIFORM_SIZE;
+	if (uniform.hasValue && std::memcmp(cached, &value, sizeof(T)) == 0) {
+		Profiler::count(Profiler::Stat::UniformsSkipped);
+		return;
+	}
+	std::memcpy(cached, &value, sizeof(T));
+	uniform.hasValue = true;
+	Profiler::count(Profiler::Stat::UniformSets);
+	uploadUniform(id, uniform.location, value);
+}
+
+template <typename T>
+UniformHandle<T> ShaderProgram::getHandle(UniformName name) const {
+	UniformHandle<T> handle = { name, findUniformIndex(name), generation };
+	if (handle.index >= 0) {
+		GLenum type = uniforms[handle.index].type;
+		bool compatible = type == uniformType<T>() || (std::is_same_v<T, int> && isSamplerType(type));
+		if (!compatible) {
+			fprintf(stderr, "Uniform %s does not match the handle type\n", uniforms[handle.index].name.c_str());
+			handle.index = -1;
+		}
+	}
+	return handle;
+}
+
+template <typename T>
+void ShaderProgram::set(UniformHandle<T>& handle, const T& value) const {
+	if (handle.generation != generation) handle = getHandle<T>(handle.name);
+	setValue(handle.index, value);
+}
+
+// handle types, see Shader.h
+#define UNIFORM_HANDLE_TYPE(T) \
+	template UniformHandle<T> ShaderProgram::getHandle<T>(UniformName name) const; \
+	template void ShaderProgram::set<T>(UniformHandle<T>& handle, const T& value) const;
+UNIFORM_HANDLE_TYPE(bool)
+UNIFORM_HANDLE_TYPE(int)
+UNIFORM_HANDLE_TYPE(float)
+UNIFORM_HANDLE_TYPE(glm::vec2)
+UNIFORM_HANDLE_TYPE(glm::vec3)
+UNIFORM_HANDLE_TYPE(glm::vec4)
+UNIFORM_HANDLE_TYPE(glm::uvec4)
+UNIFORM_HANDLE_TYPE(glm::mat2)
+UNIFORM_HANDLE_TYPE(glm::mat3)
+UNIFORM_HANDLE_TYPE(glm::mat4)
+#undef UNIFORM_HANDLE_TYPE
+
 // uniform utility funcs
 
-void ShaderProgram::setBool(const std::string& name, bool value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
+void ShaderProgram::setBool(UniformName name, bool value) const {
+	setValue(findUniformIndex(name), value);
+}
+
+void ShaderProgram::setInt(UniformName name, int value) const {
+	setValue(findUniformIndex(name), value);
 }
 
-void ShaderProgram::setInt(const std::string& name, int value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+void ShaderProgram::setFloat(UniformName name, float value) const {
+	setValue(findUniformIndex(name), value);
 }
 
-void ShaderProgram::setFloat(const std::string& name, float value) const {
-	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+void ShaderProgram::setVec2(UniformName name, const glm::vec2& value) const {
+	setValue(findUniformIndex(name), value);
 }
 
-void ShaderProgram::setVec2(const std::string& name, const glm::vec2& value) const {
-	glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+void ShaderProgram::setVec2(UniformName name, float x, float y) const {
+	setVec2(name, glm::vec2(x, y));
 }
 
-void ShaderProgram::setVec2(const std::string& name, float x, float y) const {
-	glUniform2f(glGetUniformLocation(id, name.c_str()), x, y);
+void ShaderProgram::setVec3(UniformName name, const glm::vec3& value) const {
+	setValue(findUniformIndex(name), value);
 }
 
-void ShaderProgram::setVec3(const std::string& name, const glm::vec3& value) const {
-	glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+void ShaderProgram::setVec3(UniformName name, float x, float y, float z) const {
+	setVec3(name, glm::vec3(x, y, z));
 }
 
-void ShaderProgram::setVec3(const std::string& name, float x, float y, float z) const {
-	glUniform3f(glGetUniformLocation(id, name.c_str()), x, y, z);
+void ShaderProgram::setVec4(UniformName name, const glm::vec4& value) const {
+	setValue(findUniformIndex(name), value);
 }
 
-void ShaderProgram::setVec4(const std::string& name, const glm::vec4& value) const {
-	glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+void ShaderProgram::setVec4(UniformName name, float x, float y, float z, float w) const {
+	setVec4(name, glm::vec4(x, y, z, w));
 }
 
-void ShaderProgram::setVec4(const std::string& name, float x, float y, float z, float w) const {
-	glUniform4f(glGetUniformLocation(id, name.c_str()), x, y, z, w);
+void ShaderProgram::setMat2(UniformName name, const glm::mat2& mat) const {
+	setValue(findUniformIndex(name), mat);
 }
 
-void ShaderProgram::setMat2(const std::string& name, const glm::mat2& mat) const {
-	glUniformMatrix2fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void ShaderProgram::setMat3(UniformName name, const glm::mat3& mat) const {
+	setValue(findUniformIndex(name), mat);
 }
 
-void ShaderProgram::setMat3(const std::string& name, const glm::mat3& mat) const {
-	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void ShaderProgram::setMat4(UniformName name, const glm::mat4& mat) const {
+	setValue(findUniformIndex(name), mat);
 }
 
-void ShaderProgram::setMat4(const std::string& name, const glm::mat4& mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void ShaderProgram::setUVec4(UniformName name, const glm::uvec4& value) const {
+	setValue(findUniformIndex(name), value);
 }
\ No newline at end of file
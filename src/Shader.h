@@ -3,36 +3,161 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "Hash.h"
+#include "AssetCache.h"
+#include "GLExtensions.h"
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+
+struct SpirvModule;
+
+// uniform name and its hash, string literals are hashed at compile time so passing one to a
+// setter costs nothing, other strings are hashed on the spot without allocating
+struct UniformName {
+	uint64_t hash;
+	std::string_view name;
+
+	template <size_t N>
+	consteval UniformName(const char (&str)[N]) : hash(fnv1a(std::string_view(str, N - 1))), name(str, N - 1) {}
+	UniformName(std::string_view str) : hash(fnv1a(str)), name(str) {}
+	UniformName(const std::string& str) : hash(fnv1a(str)), name(str) {}
+};
+
+// typed uniform resolved against a program once, after which setting it is an array index
+// handles re-resolve themselves if they are used with another program or after a reload,
+// so the name they were created from must outlive them (string literals always do)
+template <typename T>
+struct UniformHandle {
+	UniformName name;
+	int32_t index = -1;
+	uint32_t generation = 0;
+};
 
 class ShaderProgram {
 public:
 
-	uint32_t id;
+	// active default-block uniform, as reflected after linking
+	struct Uniform {
+		std::string name; // arrays without the "[0]" suffix
+		uint64_t hash; // fnv1a of name
+		int32_t location;
+		GLenum type;
+		int32_t arraySize;
+		mutable bool hasValue; // whether the value cache holds what was last uploaded
+	};
 
-	ShaderProgram(const char* vertPath, const char* fragPath);
+	// active uniform or shader storage block
+	struct Block {
+		std::string name;
+		bool storage;
+		int32_t binding;
+		int32_t dataSize;
+	};
+
+	uint32_t id = 0; // 0 until the first build has linked
+
+	// submits the build without waiting for it, construct every program first and then poll
+	// them so the driver can compile in parallel (KHR_parallel_shader_compile)
+	// with a cache, linked binaries are stored and reused on later launches
+	// sources may #include "file" relative to themselves, each define ("NAME" or "NAME value")
+	// is inserted after #version. precompiled x.vert.spv/x.frag.spv modules are used instead
+	// when present, with the defines setting specialization constants
+	ShaderProgram(const char* vertPath, const char* fragPath, const AssetCache* cache = nullptr, std::vector<std::string> defines = {});
+	// compute program, built the same way from glsl only
+	ShaderProgram(const char* computePath, const AssetCache* cache = nullptr, std::vector<std::string> defines = {});
 	void use();
+	// resubmit from the original files, the current program stays in use until the new one
+	// has linked and is kept if it fails
+	void reload();
+	// finish the pending build if the driver is done with it, without the extension this waits
+	// for the build, true if a new program was linked and reflected by this call
+	bool poll();
+	// finish the pending build, waiting for it if needed
+	bool wait();
+	// draws must be skipped until the first build has linked
+	bool isReady() const { return id != 0; }
+	bool isPending() const { return pending.program != 0; }
+	bool usesFile(const std::string& path) const;
 
     // uniform utility funcs
 
-    void setBool(const std::string& name, bool value) const;
-    void setInt(const std::string& name, int value) const;
-    void setFloat(const std::string& name, float value) const;
-    void setVec2(const std::string& name, const glm::vec2& value) const;
-    void setVec2(const std::string& name, float x, float y) const;
-    void setVec3(const std::string& name, const glm::vec3& value) const;
-    void setVec3(const std::string& name, float x, float y, float z) const;
-    void setVec4(const std::string& name, const glm::vec4& value) const;
-    void setVec4(const std::string& name, float x, float y, float z, float w) const;
-    void setMat2(const std::string& name, const glm::mat2& mat) const;
-    void setMat3(const std::string& name, const glm::mat3& mat) const;
-    void setMat4(const std::string& name, const glm::mat4& mat) const;
+    void setBool(UniformName name, bool value) const;
+    void setInt(UniformName name, int value) const;
+    void setFloat(UniformName name, float value) const;
+    void setVec2(UniformName name, const glm::vec2& value) const;
+    void setVec2(UniformName name, float x, float y) const;
+    void setVec3(UniformName name, const glm::vec3& value) const;
+    void setVec3(UniformName name, float x, float y, float z) const;
+    void setVec4(UniformName name, const glm::vec4& value) const;
+    void setVec4(UniformName name, float x, float y, float z, float w) const;
+    void setMat2(UniformName name, const glm::mat2& mat) const;
+    void setMat3(UniformName name, const glm::mat3& mat) const;
+    void setMat4(UniformName name, const glm::mat4& mat) const;
+    void setUVec4(UniformName name, const glm::uvec4& value) const;
+
+    // typed handles, resolving reports uniforms whose glsl type does not match T
+    // supported types: bool, int (also samplers), float, vec2-4, uvec4, mat2-4
+
+    template <typename T>
+    UniformHandle<T> getHandle(UniformName name) const;
+    template <typename T>
+    void set(UniformHandle<T>& handle, const T& value) const;
+
+    // reflection
+
+    const std::vector<Uniform>& getUniforms() const { return uniforms; }
+    const std::vector<Block>& getBlocks() const { return blocks; }
+    const Uniform* findUniform(UniformName name) const;
+    const Block* findBlock(const std::string& name) const;
 
 private:
 
-	void checkErrors(uint32_t id, std::string type);
+	// largest value a setter uploads, a mat4
+	static constexpr size_t MAX_UNIFORM_SIZE = sizeof(glm::mat4);
+
+	// bump when the layout of a cached program binary entry changes
+	static constexpr uint32_t BINARY_CACHE_MAGIC = 0x4E494250; // "PBIN"
+
+	// build submitted to the driver, shaders are kept until then for their info logs
+	struct PendingBuild {
+		uint32_t program = 0;
+		uint32_t vert = 0, frag = 0; // 0 when loaded from a binary, vert is the compute stage of compute programs
+		uint64_t key = 0;
+		std::unordered_map<int32_t, std::string> spirvNames;
+	};
+
+	std::string vertPath, fragPath;
+	std::string computePath; // set for compute programs, which have no vert and frag
+	const AssetCache* cache;
+	std::vector<std::string> defines;
+	std::vector<std::string> files; // every file the last build read, including includes
+	std::unordered_map<int32_t, std::string> spirvNames; // uniform location -> name, spir-v builds only
+	PendingBuild pending;
+
+	std::vector<Uniform> uniforms; // sorted by hash
+	std::vector<Block> blocks;
+	mutable std::vector<uint8_t> values; // last uploaded value of each uniform, MAX_UNIFORM_SIZE apart
+	uint32_t generation = 0; // unique across programs, changes on every link
+
+	void build();
+	void buildCompute();
+	bool buildSpirv();
+	uint32_t specialize(GLenum stage, const SpirvModule& module);
+	void compile(const std::string& vertSrc, const std::string& fragSrc, uint64_t key);
+	bool finish();
+	void cancel();
+	uint32_t loadBinary(uint64_t key);
+	void storeBinary(uint64_t key, uint32_t program);
+	bool checkErrors(uint32_t id, std::string type);
+	std::string describe() const;
+	bool reflect();
+	int32_t findUniformIndex(UniformName name) const;
+	template <typename T>
+	void setValue(int32_t index, const T& value) const;
 
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "ShaderVariants.h"
+
+ShaderVariants::ShaderVariants(const char* vertPath, const char* fragPath, const AssetCache* cache, std::vector<std::string> defines)
+    : vertPath(vertPath), fragPath(fragPath), cache(cache), defines(std::move(defines)) {
+}
+
+ShaderProgram& ShaderVariants::get(uint32_t features) {
+    auto it = variants.find(features);
+    if (it != variants.end()) return *it->second;
+
+    std::vector<std::string> defines = this->defines;
+    for (uint32_t i = 0; i < MATERIAL_FEATURE_COUNT; i++) {
+        std::string name = getFeatureName((MaterialFeature)(1u << i));
+        defines.push_back(name + ((features & (1u << i)) ? " true" : " false"));
+    }
+
+    auto program = std::make_unique<ShaderProgram>(vertPath.c_str(), fragPath.c_str(), cache, defines);
+    return *variants.emplace(features, std::move(program)).first->second;
+}
+
+ShaderProgram* ShaderVariants::find(uint32_t features) const {
+    auto it = variants.find(features);
+    return it != variants.end() ? it->second.get() : nullptr;
+}
+
+void ShaderVariants::poll() {
+    for (auto& [features, program] : variants) {
+        if (!program->poll()) continue;
+        for (auto& callback : linkCallbacks)
+            callback(*program);
+    }
+}
+
+void ShaderVariants::addLinkCallback(std::function<void(ShaderProgram&)> callback) {
+    linkCallbacks.push_back(std::move(callback));
+}
+
+bool ShaderVariants::usesFile(const std::string& path) const {
+    if (path == vertPath || path == fragPath) return true;
+    for (auto& [features, program] : variants)
+        if (program->usesFile(path)) return true;
+    return false;
+}
+
+void ShaderVariants::reload(const std::string& path) {
+    for (auto& [features, program] : variants)
+        if (program->usesFile(path)) program->reload();
+}
+
+const char* ShaderVariants::getFeatureName(MaterialFeature feature) {
+    switch (feature) {
+    case HAS_DIFFUSE_MAP: return "HAS_DIFFUSE_MAP";
+    case HAS_SPECULAR_MAP: return "HAS_SPECULAR_MAP";
+    case HAS_NORMAL_MAP: return "HAS_NORMAL_MAP";
+    case HAS_PARALLAX: return "HAS_PARALLAX";
+    default: return "";
+    }
+}
\ No newline at end of file
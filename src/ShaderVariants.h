@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// material features a shader variant is specialised for, each becomes a define (or, for spir-v
+// builds, a specialization constant) of the same name set to true or false
+enum MaterialFeature : uint32_t {
+    HAS_DIFFUSE_MAP = 1 << 0,
+    HAS_SPECULAR_MAP = 1 << 1,
+    HAS_NORMAL_MAP = 1 << 2,
+    HAS_PARALLAX = 1 << 3,
+    MATERIAL_FEATURE_COUNT = 4
+};
+
+// permutations of one vertex/fragment pair, built on first use and cached by feature bitmask
+class ShaderVariants {
+public:
+    // defines are shared by every variant
+    ShaderVariants(const char* vertPath, const char* fragPath, const AssetCache* cache = nullptr, std::vector<std::string> defines = {});
+
+    // the variant for a feature set, submitted for compilation the first time it is asked for,
+    // check isReady() before drawing with it
+    ShaderProgram& get(uint32_t features);
+    // the variant if it was asked for before, nullptr otherwise. never builds, so unlike get()
+    // it may be called from worker threads as long as the gl thread is not adding variants
+    ShaderProgram* find(uint32_t features) const;
+    // polls every pending variant, link callbacks run for each one that finished
+    void poll();
+    // called with each variant once it has linked, e.g. to validate its blocks
+    void addLinkCallback(std::function<void(ShaderProgram&)> callback);
+
+    bool usesFile(const std::string& path) const;
+    // resubmits every variant built from the file
+    void reload(const std::string& path);
+
+    size_t getCount() const { return variants.size(); }
+    static const char* getFeatureName(MaterialFeature feature);
+
+private:
+    std::string vertPath, fragPath;
+    const AssetCache* cache;
+    std::vector<std::string> defines;
+    std::unordered_map<uint32_t, std::unique_ptr<ShaderProgram>> variants;
+    std::vector<std::function<void(ShaderProgram&)>> linkCallbacks;
+};
\ No newline at end of file
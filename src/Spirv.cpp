@@ -0,0 +1,63 @@
+#include "Spirv.h"
+
+#include <cstring>
+#include <fstream>
+
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+static constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+
+// opcodes, decorations and storage classes used below, see the spir-v specification
+static constexpr uint32_t OP_NAME = 5;
+static constexpr uint32_t OP_VARIABLE = 59;
+static constexpr uint32_t OP_DECORATE = 71;
+static constexpr uint32_t DECORATION_SPEC_ID = 1;
+static constexpr uint32_t DECORATION_LOCATION = 30;
+static constexpr uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+
+bool loadSpirv(const std::string& path, SpirvModule& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = file.tellg();
+    if (size < (std::streamsize)(SPIRV_HEADER_WORDS * 4) || size % 4 != 0) return false;
+    out.words.resize(size / 4);
+    file.seekg(0);
+    if (!file.read((char*)out.words.data(), size) || out.words[0] != SPIRV_MAGIC) return false;
+
+    std::unordered_map<uint32_t, std::string> names;
+    std::unordered_map<uint32_t, int32_t> locations;
+    std::unordered_map<uint32_t, uint32_t> specIds;
+    std::vector<uint32_t> uniformConstants;
+
+    const std::vector<uint32_t>& words = out.words;
+    for (size_t i = SPIRV_HEADER_WORDS; i < words.size();) {
+        uint32_t opcode = words[i] & 0xFFFF;
+        uint32_t count = words[i] >> 16;
+        if (count == 0 || i + count > words.size()) return false;
+
+        if (opcode == OP_NAME && count >= 3) {
+            const char* str = (const char*)&words[i + 2];
+            names[words[i + 1]] = std::string(str, strnlen(str, (count - 2) * 4));
+        }
+        else if (opcode == OP_DECORATE && count >= 4) {
+            if (words[i + 2] == DECORATION_LOCATION) locations[words[i + 1]] = (int32_t)words[i + 3];
+            else if (words[i + 2] == DECORATION_SPEC_ID) specIds[words[i + 1]] = words[i + 3];
+        }
+        else if (opcode == OP_VARIABLE && count >= 4 && words[i + 3] == STORAGE_UNIFORM_CONSTANT) {
+            uniformConstants.push_back(words[i + 2]);
+        }
+        i += count;
+    }
+
+    out.uniformNames.clear();
+    out.specIds.clear();
+    for (uint32_t id : uniformConstants) {
+        auto location = locations.find(id);
+        auto name = names.find(id);
+        if (location != locations.end() && name != names.end()) out.uniformNames[location->second] = name->second;
+    }
+    for (auto& [id, specId] : specIds) {
+        auto name = names.find(id);
+        if (name != names.end()) out.specIds[name->second] = specId;
+    }
+    return true;
+}
\ No newline at end of file
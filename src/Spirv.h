@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// a spir-v module as loaded for glShaderBinary, plus the little reflection gl does not give us:
+// name-based queries do not work on spir-v programs, so names are recovered from the module's
+// OpName debug instructions (emitted by glslangValidator unless stripped)
+struct SpirvModule {
+    std::vector<uint32_t> words;
+    std::unordered_map<int32_t, std::string> uniformNames; // default-block uniform location -> name
+    std::unordered_map<std::string, uint32_t> specIds; // specialization constant name -> constant_id
+};
+
+// false if the file is missing or not a spir-v module
+bool loadSpirv(const std::string& path, SpirvModule& out);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "TextureFeedback.h"
+#include "GLState.h"
+
+TextureFeedback::TextureFeedback() : desiredMips(MAX_TEXTURES, NOT_SAMPLED) {
+    constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr GLsizeiptr size = MAX_TEXTURES * sizeof(uint32_t);
+
+    // persistently mapped so reading a finished frame is a plain memcpy
+    glCreateBuffers(LATENCY, buffers);
+    for (uint32_t i = 0; i < LATENCY; i++) {
+        glNamedBufferStorage(buffers[i], size, nullptr, flags);
+        mapped[i] = (uint32_t*)glMapNamedBufferRange(buffers[i], 0, size, flags);
+    }
+}
+
+TextureFeedback::~TextureFeedback() {
+    for (uint32_t i = 0; i < LATENCY; i++)
+        if (fences[i]) glDeleteSync(fences[i]);
+    glDeleteBuffers(LATENCY, buffers);
+}
+
+void TextureFeedback::beginFrame() {
+    if (!enabled) return;
+
+    uint32_t slot = frame % LATENCY;
+    readback(slot);
+
+    // reset slot and bind it for this frame's writes
+    uint32_t clearValue = NOT_SAMPLED;
+    glClearNamedBufferData(buffers[slot], GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &clearValue);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffers[slot]);
+}
+
+void TextureFeedback::endFrame() {
+    if (!enabled) return;
+
+    // make shader writes visible to the mapped pointer once the fence signals
+    glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    fences[frame % LATENCY] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame++;
+}
+
+uint32_t TextureFeedback::getDesiredMip(uint32_t texture) const {
+    if (texture >= MAX_TEXTURES) return NOT_SAMPLED;
+    return desiredMips[texture];
+}
+
+void TextureFeedback::readback(uint32_t slot) {
+    if (!fences[slot]) return;
+
+    // never block, if the gpu is still behind this frame's result is dropped
+    GLenum status = glClientWaitSync(fences[slot], 0, 0);
+    glDeleteSync(fences[slot]);
+    fences[slot] = nullptr;
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+
+    sampledCount = 0;
+    for (uint32_t i = 0; i < MAX_TEXTURES; i++) {
+        desiredMips[i] = mapped[slot][i];
+        if (desiredMips[i] != NOT_SAMPLED) sampledCount++;
+    }
+}
\ No newline at end of file
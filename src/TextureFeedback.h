@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+// records the mip level each texture is actually sampled at, as written by model.frag
+// into an ssbo, and reads it back a few frames later without stalling the gpu
+class TextureFeedback {
+public:
+    static constexpr uint32_t MAX_TEXTURES = 4096; // entries are indexed by gl texture name
+    static constexpr uint32_t LATENCY = 3; // frames between writing a buffer and reading it back
+    static constexpr uint32_t BINDING = 0; // ssbo binding point used by model.frag
+    static constexpr uint32_t NOT_SAMPLED = 0xFFFFFFFF;
+
+    bool enabled = false;
+
+    TextureFeedback();
+    ~TextureFeedback();
+
+    // call around the draws that should record feedback, shaders read enabled through
+    // FrameConstants::feedbackEnabled
+    void beginFrame();
+    void endFrame();
+
+    // results of the latest completed readback
+    uint32_t getDesiredMip(uint32_t texture) const;
+    uint32_t getSampledCount() const { return sampledCount; }
+
+private:
+    uint32_t buffers[LATENCY] = {};
+    uint32_t* mapped[LATENCY] = {};
+    GLsync fences[LATENCY] = {};
+    uint32_t frame = 0;
+
+    std::vector<uint32_t> desiredMips;
+    uint32_t sampledCount = 0;
+
+    void readback(uint32_t slot);
+};
\ No newline at end of file
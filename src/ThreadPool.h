@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads for data-parallel jobs, the calling thread joins in as well
+// NOTE: jobs must not call parallelFor on the same pool, that would deadlock
+class ThreadPool {
+public:
+    ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    // runs fn(i) for every i in [0, count) across all threads and returns once all are done
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+    unsigned getThreadCount() const { return (unsigned)workers.size() + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex submitMutex; // one job at a time
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> next = 0;
+    size_t busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runJob();
+};
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "UploadQueue.h"
+#include "GLState.h"
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+
+static GLenum formatForComponents(int components) {
+    if (components == 1) return GL_RED;
+    if (components == 2) return GL_RG;
+    if (components == 3) return GL_RGB;
+    return GL_RGBA;
+}
+
+UploadQueue::~UploadQueue() {
+    for (Job& job : jobs)
+        stbi_image_free(job.pixels);
+}
+
+void UploadQueue::enqueueTexture(uint32_t texture, int width, int height, int components, unsigned char* pixels) {
+    size_t rowBytes = (size_t)width * components;
+    int rowsPerPiece = (int)std::max<size_t>(1, MAX_PIECE_BYTES / rowBytes);
+    jobs.push_back({ texture, width, height, components, pixels, 0, rowsPerPiece, 0.0f });
+}
+
+void UploadQueue::cancel(uint32_t texture) {
+    for (size_t i = 0; i < jobs.size();) {
+        if (jobs[i].texture == texture) {
+            stbi_image_free(jobs[i].pixels);
+            jobs.erase(jobs.begin() + i);
+        }
+        else i++;
+    }
+}
+
+void UploadQueue::setPriority(uint32_t texture, float priority) {
+    for (Job& job : jobs)
+        if (job.texture == texture) job.priority = priority;
+}
+
+void UploadQueue::process() {
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+    bytesLastFrame = 0;
+    msLastFrame = 0.0;
+    if (jobs.empty()) return;
+
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.priority < b.priority; });
+
+    GLState::pixelStore(GL_UNPACK_ALIGNMENT, 1);
+    size_t i = 0;
+    while (i < jobs.size()) {
+        bytesLastFrame += uploadPiece(jobs[i]);
+        msLastFrame = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        if (jobs[i].nextRow >= jobs[i].height) {
+            // last band done, build the mip chain and release the image
+            glGenerateTextureMipmap(jobs[i].texture);
+            stbi_image_free(jobs[i].pixels);
+            jobs.erase(jobs.begin() + i);
+        }
+        if (bytesLastFrame >= budgetBytes || msLastFrame >= budgetMs) break;
+    }
+    GLState::pixelStore(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool UploadQueue::isPending(uint32_t texture) const {
+    for (const Job& job : jobs)
+        if (job.texture == texture) return true;
+    return false;
+}
+
+size_t UploadQueue::getDepth() const {
+    size_t depth = 0;
+    for (const Job& job : jobs)
+        depth += (job.height - job.nextRow + job.rowsPerPiece - 1) / job.rowsPerPiece;
+    return depth;
+}
+
+size_t UploadQueue::uploadPiece(Job& job) {
+    int rows = std::min(job.rowsPerPiece, job.height - job.nextRow);
+    size_t rowBytes = (size_t)job.width * job.components;
+
+    glTextureSubImage2D(job.texture, 0, 0, job.nextRow, job.width, rows,
+        formatForComponents(job.components), GL_UNSIGNED_BYTE, job.pixels + job.nextRow * rowBytes);
+
+    job.nextRow += rows;
+    return rows * rowBytes;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// defers texture uploads and drains them with a per-frame budget so that a burst of
+// decoded textures is spread over several frames instead of hitching one
+class UploadQueue {
+public:
+    size_t budgetBytes = 8 << 20; // per frame
+    double budgetMs = 2.0; // per frame, measured on the cpu around each upload
+    static constexpr size_t MAX_PIECE_BYTES = 1 << 20; // large images are split into row bands of this size
+
+    ~UploadQueue();
+
+    // takes ownership of stbi-allocated pixels, the texture must already have immutable storage
+    void enqueueTexture(uint32_t texture, int width, int height, int components, unsigned char* pixels);
+    // drop any pending upload for a texture, e.g. before it is replaced or deleted
+    void cancel(uint32_t texture);
+    // lower values upload first
+    void setPriority(uint32_t texture, float priority);
+    // upload pieces until either budget is spent, at least one piece is always uploaded
+    void process();
+
+    bool isPending(uint32_t texture) const;
+    size_t getDepth() const; // outstanding pieces
+    size_t getBytesLastFrame() const { return bytesLastFrame; }
+    double getMsLastFrame() const { return msLastFrame; }
+
+private:
+    struct Job {
+        uint32_t texture;
+        int width, height, components;
+        unsigned char* pixels;
+        int nextRow;
+        int rowsPerPiece;
+        float priority;
+    };
+
+    std::vector<Job> jobs;
+    size_t bytesLastFrame = 0;
+    double msLastFrame = 0.0;
+
+    size_t uploadPiece(Job& job);
+};
\ No newline at end of file
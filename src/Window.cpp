@@ -1,4 +1,6 @@
 #include "Window.h"
+#include "GLExtensions.h"
+#include "GLState.h"
 #include <cstdlib>
 #include <stdio.h>
 #include <iostream>
@@ -9,12 +11,6 @@ static void error_callback(int error, const char* description) {
 	fprintf_s(stderr, "Error: %s\n", description);
 }
 
-static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
-	width = width;
-	height = height;
-}
-
 // window constructor
 
 Window::Window() {
@@ -41,7 +37,6 @@ Window::Window() {
 	// register window & callbacks
 	glfwSetWindowUserPointer(wnd, this);
 	glfwMakeContextCurrent(wnd);
-	glfwSetFramebufferSizeCallback(wnd, framebuffer_size_callback);
 
 	// init glad
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -49,6 +44,8 @@ Window::Window() {
 		glfwTerminate();
 		exit(EXIT_FAILURE);
 	}
+	GLExtensions::init();
+	GLState::invalidate();
 
 	// init InputManager
 	inputManager = new InputManager(wnd);